@@ -16,7 +16,7 @@
 #' Generating and editing genotype data.
 #' 
 #' Build date: Nov 14, 2018
-#' Last update: Apr 28, 2022
+#' Last update: Oct 17, 2026
 #'
 #' @author Dong Yin
 #'
@@ -34,6 +34,9 @@
 #' \item{$geno$prob}{the genotype code probability.}
 #' \item{$geno$rate.mut}{the mutation rate of the genotype data.}
 #' \item{$geno$cld}{whether to generate a complete LD genotype data when 'incols == 2'.}
+#' \item{$geno$monitor}{whether to calculate population genetic statistics and pedigree inbreeding of every generation.}
+#' \item{$geno$pop.stat}{the population genetic statistics of every generation when 'monitor' is TRUE.}
+#' \item{$geno$ibd}{whether to track the founder haplotypes of every individual, see cal.ibd.}
 #' }
 #' 
 #' @export
@@ -128,6 +131,12 @@ genotype <- function(SP = NULL, ncpus = 0, verbose = TRUE) {
   SP$geno$pop.marker <- pop.marker <- nrow(bigmat)
   SP$geno$pop.ind <- pop.ind <- ncol(bigmat) / incols
   
+  # every haplotype without a track is taken as a founder
+  ibd <- isTRUE(SP$geno$ibd) & incols == 2
+  if (ibd & is.null(attr(bigmat, "ibd"))) {
+    attr(bigmat, "ibd") <- IbdFounder(m = pop.marker, nhap = ncol(bigmat))
+  }
+  
   if (!is.null(pop.map)) {
     if (nrow(bigmat) != nrow(pop.map)) {
       stop("Marker number should be same in both 'pop.map' and 'pop.geno'!")
@@ -143,6 +152,9 @@ genotype <- function(SP = NULL, ncpus = 0, verbose = TRUE) {
         bigmat[Recom, (2*ind)] <- bigmat[Recom, (2*ind-1)]
         bigmat[Recom, (2*ind-1)] <- geno.swap
       }
+      if (ibd & length(Recom) > 0 & length(ind.swap) > 0) {
+        IbdSwap(attr(bigmat, "ibd"), rows = Recom, inds = ind.swap, threads = ncpus)
+      }
     }
     
     if (!is.null(rate.mut)) {
@@ -182,6 +194,13 @@ genotype <- function(SP = NULL, ncpus = 0, verbose = TRUE) {
     SP$geno$pop.geno[[length(SP$geno$pop.geno)]] <- bigmat
   }
   names(SP$geno$pop.geno)[length(SP$geno$pop.geno)] <- paste0("gen", length(SP$geno$pop.geno))
+  
+  if (isTRUE(SP$geno$monitor)) {
+    SP <- cal.popgen(SP, gen = length(SP$geno$pop.geno), ncpus = ncpus, verbose = FALSE)
+    if (!is.null(SP$pheno$pop)) {
+      SP <- cal.inbreed(SP, verbose = FALSE)
+    }
+  }
   return(SP)
 }
 
@@ -641,3 +660,482 @@ geno.cvt2 <- function(pop.geno) {
   
   return(geno)
 }
+
+#' Linkage disequilibrium
+#' 
+#' Calculate linkage disequilibrium (r2 and D') of a generation in the simulation, with LD decay summarized by distance bins.
+#'
+#' Build date: Oct 17, 2026
+#' Last update: Oct 17, 2026
+#'
+#' @author Dong Yin
+#'
+#' @param SP a list of all simulation parameters.
+#' @param gen the generation (index or name in 'SP$geno$pop.geno') to be calculated, the last generation is used if NULL.
+#' @param type the data used for LD, 'haplotype' (haplotype frequencies, it needs 'incols == 2') or 'dosage' (correlation of 0/1/2 genotypes).
+#' @param mode 'window': marker pairs within a sliding window; 'region': all marker pairs in 'region'.
+#' @param win.snp the maximum number of markers between two markers of a pair in 'window' mode.
+#' @param win.bp the maximum physical distance (bp) between two markers of a pair in 'window' mode.
+#' @param bin.size the distance bin (bp) of the LD decay summary.
+#' @param region the marker indices used in 'region' mode.
+#' @param keep.pairs whether to return LD of every marker pair in 'window' mode.
+#' @param ncpus the number of threads used, if NULL, (logical core number - 1) is automatically used.
+#' @param verbose whether to print detail.
+#'
+#' @return 
+#' in 'window' mode, the function returns a list containing
+#' \describe{
+#' \item{$decay}{the LD decay summary, including start and end of distance bin, number of pairs, mean r2 and mean |D'|.}
+#' \item{$pairs}{NULL, or LD of every marker pair when 'keep.pairs' is TRUE.}
+#' }
+#' in 'region' mode, the function returns a list containing
+#' \describe{
+#' \item{$r2}{the r2 matrix of markers in the region.}
+#' \item{$Dprime}{the D' matrix of markers in the region.}
+#' }
+#' 
+#' @export
+#'
+#' @examples
+#' \donttest{
+#' SP <- param.annot(qtn.num = list(tr1 = 10))
+#' SP <- param.geno(SP = SP, pop.marker = 1e4, pop.ind = 1e2)
+#' SP <- annotation(SP)
+#' SP <- genotype(SP)
+#' ld <- cal.ld(SP)
+#' head(ld$decay)
+#' }
+cal.ld <- function(SP, gen = NULL, type = "haplotype", mode = "window", win.snp = 100, win.bp = 1e6, bin.size = 1e5, region = NULL, keep.pairs = FALSE, ncpus = 0, verbose = TRUE) {
+  
+  pop.geno <- SP$geno$pop.geno
+  if (is.null(pop.geno)) {
+    stop("Please run genotype simulation before calculating LD!")
+  }
+  if (is.big.matrix(pop.geno) | is.matrix(pop.geno)) {
+    bigmat <- pop.geno
+  } else {
+    if (is.null(gen)) { gen <- length(pop.geno) }
+    bigmat <- pop.geno[[gen]]
+  }
+  if (!is.big.matrix(bigmat)) {
+    geno <- as.matrix(bigmat)
+    bigmat <- big.matrix(
+      nrow = nrow(geno),
+      ncol = ncol(geno),
+      init = 3,
+      type = 'char')
+    Mat2BigMat(bigmat@address, mat = geno, threads = ncpus)
+    rm(geno); gc()
+  }
+  
+  incols <- SP$geno$incols
+  if (is.null(incols)) { incols <- 2 }
+  if (!(type %in% c("haplotype", "dosage"))) {
+    stop("'type' should be 'haplotype' or 'dosage'!")
+  }
+  if (type == "haplotype" & incols != 2) {
+    stop("LD of 'haplotype' needs genotype with 'incols == 2'!")
+  }
+  
+  if (mode == "window") {
+    pop.map <- SP$map$pop.map
+    if (is.null(pop.map)) {
+      chrom <- rep(1L, nrow(bigmat))
+      pos <- as.numeric(1:nrow(bigmat))
+    } else {
+      if (nrow(pop.map) != nrow(bigmat)) {
+        stop("Marker number should be same in both 'pop.map' and 'pop.geno'!")
+      }
+      chrom <- as.integer(factor(pop.map$Chrom, levels = unique(pop.map$Chrom)))
+      pos <- as.numeric(pop.map$BP)
+    }
+    logging.log(" Calculate LD in sliding windows...\n", verbose = verbose)
+    ld <- LDWindow(bigmat@address, chrom, pos, incols = incols, haplotype = (type == "haplotype"), winSNP = win.snp, winBP = win.bp, binSize = bin.size, keepPairs = keep.pairs, threads = ncpus, verbose = verbose)
+    
+  } else if (mode == "region") {
+    if (is.null(region)) {
+      stop("Please input the marker indices of 'region'!")
+    }
+    logging.log(" Calculate LD of all marker pairs in region...\n", verbose = verbose)
+    ld <- LDRegion(bigmat@address, as.integer(region), incols = incols, haplotype = (type == "haplotype"), threads = ncpus, verbose = verbose)
+    
+  } else {
+    stop("'mode' should be 'window' or 'region'!")
+  }
+  
+  return(ld)
+}
+
+#' Population genetics monitor
+#' 
+#' Calculate population genetic statistics of generations in the simulation, including allele frequency, expected and observed heterozygosity, fixed and lost markers, site frequency spectrum, and Fst among sub-populations.
+#'
+#' Build date: Oct 17, 2026
+#' Last update: Oct 17, 2026
+#'
+#' @author Dong Yin
+#'
+#' @param SP a list of all simulation parameters.
+#' @param gen the generations (indices in 'SP$geno$pop.geno') to be calculated, the generations without statistics are used if NULL.
+#' @param group the sub-population (such as breed) of every individual, only used when a single generation is calculated.
+#' @param nbin the number of frequency bins of site frequency spectrum.
+#' @param ncpus the number of threads used, if NULL, (logical core number - 1) is automatically used.
+#' @param verbose whether to print detail.
+#'
+#' @return 
+#' the function returns a list containing
+#' \describe{
+#' \item{$geno$pop.stat}{a list of population genetic statistics of every generation, including 'freq' (the frequency of allele '1' of every marker), 'He', 'Ho', 'fixed', 'lost', 'sfs', and 'Fst'.}
+#' }
+#' 
+#' @export
+#'
+#' @examples
+#' \donttest{
+#' SP <- param.annot(qtn.num = list(tr1 = 10))
+#' SP <- param.geno(SP = SP, pop.marker = 1e4, pop.ind = 1e2)
+#' SP <- annotation(SP)
+#' SP <- genotype(SP)
+#' SP <- cal.popgen(SP, group = rep(1:2, each = 50))
+#' SP$geno$pop.stat$gen1$Fst
+#' }
+cal.popgen <- function(SP, gen = NULL, group = NULL, nbin = 10, ncpus = 0, verbose = TRUE) {
+  
+  pop.geno <- SP$geno$pop.geno
+  incols <- SP$geno$incols
+  if (is.null(pop.geno)) {
+    stop("Please run genotype simulation before calculating population genetic statistics!")
+  }
+  if (is.null(gen)) {
+    gen <- which(!(names(pop.geno) %in% names(SP$geno$pop.stat)))
+  }
+  if (!is.null(group) & length(gen) != 1) {
+    stop("'group' can only be used in a single generation!")
+  }
+  if (!is.null(group)) {
+    group <- match(group, unique(group))
+  }
+  
+  for (i in gen) {
+    stat <- GenoStat(pop.geno[[i]]@address, incols = incols, group = group, nBin = nbin, threads = ncpus)
+    if (is.null(SP$geno$pop.stat)) { SP$geno$pop.stat <- list() }
+    SP$geno$pop.stat[[names(pop.geno)[i]]] <- stat
+    logging.log(" Population genetics of", names(pop.geno)[i], ": He =", round(stat$He, 4), ", Ho =", round(stat$Ho, 4), ", fixed =", stat$fixed, ", lost =", stat$lost, "\n", verbose = verbose)
+  }
+  
+  return(SP)
+}
+
+#' Runs of homozygosity
+#' 
+#' Detect runs of homozygosity (ROH) of generations in the simulation, and calculate the genomic inbreeding coefficient F_ROH of every individual and every generation.
+#'
+#' Build date: Oct 17, 2026
+#' Last update: Oct 17, 2026
+#'
+#' @author Dong Yin
+#'
+#' @param SP a list of all simulation parameters.
+#' @param gen the generations (indices in 'SP$geno$pop.geno') to be scanned, all generations are used if NULL.
+#' @param min.snp the minimum number of markers in a ROH.
+#' @param min.bp the minimum length (bp) of a ROH.
+#' @param max.het the maximum number of heterozygous markers allowed in a ROH.
+#' @param max.gap the maximum gap (bp) between two adjacent markers in a ROH.
+#' @param max.density the maximum average distance (bp) per marker of a ROH, no limit if 0.
+#' @param keep.seg whether to return every ROH segment.
+#' @param ncpus the number of threads used, if NULL, (logical core number - 1) is automatically used.
+#' @param verbose whether to print detail.
+#'
+#' @return 
+#' the function returns a list containing
+#' \describe{
+#' \item{$ind}{the number and total length of ROH, and F_ROH of every individual.}
+#' \item{$gen}{the mean and standard deviation of F_ROH of every generation.}
+#' \item{$seg}{NULL, or every ROH segment when 'keep.seg' is TRUE.}
+#' }
+#' 
+#' @export
+#'
+#' @examples
+#' \donttest{
+#' SP <- param.annot(qtn.num = list(tr1 = 10))
+#' SP <- param.geno(SP = SP, pop.marker = 1e4, pop.ind = 1e2)
+#' SP <- annotation(SP)
+#' SP <- genotype(SP)
+#' roh <- cal.roh(SP, min.snp = 20, min.bp = 1e5)
+#' head(roh$ind)
+#' }
+cal.roh <- function(SP, gen = NULL, min.snp = 50, min.bp = 1e6, max.het = 1, max.gap = 1e6, max.density = 5e4, keep.seg = FALSE, ncpus = 0, verbose = TRUE) {
+  
+  pop.geno <- SP$geno$pop.geno
+  pop.map <- SP$map$pop.map
+  incols <- SP$geno$incols
+  if (is.null(pop.geno)) {
+    stop("Please run genotype simulation before detecting ROH!")
+  }
+  if (is.null(pop.map)) {
+    stop("'pop.map' is necessary for detecting ROH!")
+  }
+  if (is.null(gen)) { gen <- seq_along(pop.geno) }
+  chrom <- match(pop.map$Chrom, unique(pop.map$Chrom))
+  pos <- as.numeric(pop.map$BP)
+  
+  roh.ind <- roh.seg <- NULL
+  for (i in gen) {
+    gen.name <- names(pop.geno)[i]
+    logging.log(" Detect runs of homozygosity of", gen.name, "...\n", verbose = verbose)
+    roh <- ROHCall(pop.geno[[i]]@address, chrom, pos, incols = incols, minSNP = min.snp, minBP = min.bp,
+                   maxHet = max.het, maxGap = max.gap, maxDensity = max.density, keepSegments = keep.seg, threads = ncpus, verbose = verbose)
+    pop <- SP$pheno$pop[[gen.name]]
+    if (!is.null(pop) && nrow(pop) == nrow(roh$ind)) {
+      index <- pop$index
+    } else {
+      index <- seq_len(nrow(roh$ind))
+    }
+    roh.ind <- rbind(roh.ind, data.frame(index = index, gen = gen.name, roh$ind))
+    if (keep.seg) {
+      seg <- roh$seg
+      seg$ind <- index[seg$ind]
+      seg$chrom <- unique(pop.map$Chrom)[seg$chrom]
+      roh.seg <- rbind(roh.seg, data.frame(gen = gen.name, seg))
+    }
+  }
+  
+  froh.mean <- tapply(roh.ind$FROH, roh.ind$gen, mean)
+  froh.sd <- tapply(roh.ind$FROH, roh.ind$gen, sd)
+  gen.names <- unique(roh.ind$gen)
+  roh.gen <- data.frame(gen = gen.names, meanFROH = as.numeric(froh.mean[gen.names]), sdFROH = as.numeric(froh.sd[gen.names]))
+  
+  return(list(ind = roh.ind, gen = roh.gen, seg = roh.seg))
+}
+
+#' Genotype principal component analysis
+#' 
+#' Calculate the top principal components of the standardized genotype of generations in the simulation by randomized block Krylov SVD.
+#' The genotype is streamed block by block a fixed number of times, and the kinship matrix is never formed, so that it works for populations of 100k+ individuals, e.g. crossbred populations by 'mate.2waycro', 'mate.3waycro', and 'mate.4waycro'.
+#'
+#' Build date: Oct 17, 2026
+#' Last update: Oct 17, 2026
+#'
+#' @author Dong Yin
+#'
+#' @param SP a list of all simulation parameters.
+#' @param gen the generations (indices in 'SP$geno$pop.geno') analyzed together, all generations are used if NULL.
+#' @param k the number of principal components.
+#' @param method 'VanRaden' (centered genotype) or 'Yang' (standardized genotype).
+#' @param iter the number of Krylov iterations, i.e., passes over the genotype, cut down so that (k + oversample) * iter is not more than the individual number.
+#' @param oversample the number of extra random vectors of every Krylov block, cut down so that k + oversample is not more than the individual number.
+#' @param kin whether to return the factor of the rank-k kinship approximation.
+#' @param mem.limit the memory limit (MB) of a genotype block.
+#' @param ncpus the number of threads used, if NULL, (logical core number - 1) is automatically used.
+#' @param verbose whether to print detail.
+#'
+#' @return 
+#' the function returns a list containing
+#' \describe{
+#' \item{$pcs}{the individual index, the generation, and the top k principal components of every individual.}
+#' \item{$values}{the top k eigenvalues of the genomic relationship matrix.}
+#' \item{$loadings}{the marker loadings (right singular vectors).}
+#' \item{$kin.factor}{NULL, or the n * k matrix F when 'kin' is TRUE, the genomic relationship matrix being approximated by F * t(F).}
+#' }
+#' 
+#' @export
+#'
+#' @references C. Musco, C. Musco (2015) Randomized block Krylov methods for stronger and faster approximate singular value decomposition. Advances in Neural Information Processing Systems, 28: P1396-P1404
+#'
+#' @examples
+#' \donttest{
+#' SP <- param.annot(qtn.num = list(tr1 = 10))
+#' SP <- param.geno(SP = SP, pop.marker = 1e4, pop.ind = 1e2)
+#' SP <- annotation(SP)
+#' SP <- genotype(SP)
+#' pca <- cal.pca(SP, k = 3)
+#' head(pca$pcs)
+#' }
+cal.pca <- function(SP, gen = NULL, k = 10, method = "VanRaden", iter = 4, oversample = 10, kin = FALSE, mem.limit = 256, ncpus = 0, verbose = TRUE) {
+  
+  pop.geno <- SP$geno$pop.geno
+  incols <- SP$geno$incols
+  if (is.null(pop.geno)) {
+    stop("Please run genotype simulation before principal component analysis!")
+  }
+  if (is.null(gen)) { gen <- seq_along(pop.geno) }
+  
+  logging.log(" Principal component analysis of", paste(names(pop.geno)[gen], collapse = ", "), "...\n", verbose = verbose)
+  pca <- GrmPCA(lapply(pop.geno[gen], function(x) { return(x@address) }), method = method, incols = incols, k = k,
+                iter = iter, oversample = oversample, memLimit = mem.limit, threads = ncpus, verbose = verbose)
+  
+  pcs <- do.call(rbind, lapply(gen, function(i) {
+    gen.name <- names(pop.geno)[i]
+    n <- ncol(pop.geno[[i]]) / incols
+    pop <- SP$pheno$pop[[gen.name]]
+    if (!is.null(pop) && nrow(pop) == n) {
+      index <- pop$index
+    } else {
+      index <- seq_len(n)
+    }
+    return(data.frame(index = index, gen = gen.name))
+  }))
+  pc <- pca$pcs
+  colnames(pc) <- paste0("PC", 1:k)
+  pcs <- cbind(pcs, pc)
+  
+  kin.factor <- NULL
+  if (kin) {
+    kin.factor <- sweep(pca$vectors, 2, sqrt(pca$values), "*")
+  }
+  logging.log(" Eigenvalues of the top", k, "principal components:", round(pca$values, 4), "\n", verbose = verbose)
+  
+  return(list(pcs = pcs, values = pca$values, loadings = pca$loadings, kin.factor = kin.factor))
+}
+
+#' Realized IBD relationship
+#' 
+#' Calculate the realized relationship and the inbreeding coefficient of individuals by identity by descent (IBD), from the founder-haplotype labels tracked through meiosis when 'ibd' of genotype parameters is TRUE.
+#' Every haplotype of the base population gets its own label, the labels are copied along with the haplotypes by mating and exchanged along with the chromosome exchange, and the relationship is computed by intersecting the label segments, so that it is exact rather than estimated from the marker states.
+#'
+#' Build date: Oct 17, 2026
+#' Last update: Oct 17, 2026
+#'
+#' @author Dong Yin
+#'
+#' @param SP a list of all simulation parameters.
+#' @param gen the generations (indices in 'SP$geno$pop.geno') analyzed together, all generations are used if NULL.
+#' @param ind the individual indices to be analyzed, all individuals of 'gen' are used if NULL.
+#' @param ncpus the number of threads used, if NULL, (logical core number - 1) is automatically used.
+#' @param verbose whether to print detail.
+#'
+#' @return 
+#' the function returns a list containing
+#' \describe{
+#' \item{$kin}{the realized IBD relationship matrix, i.e., twice the fraction of markers shared IBD by two individuals, the diagonal being 1 + F.}
+#' \item{$ind}{the individual index, the generation, and the IBD inbreeding coefficient F of every individual.}
+#' \item{$gen}{the mean and standard deviation of F of every generation.}
+#' }
+#' 
+#' @export
+#'
+#' @examples
+#' \donttest{
+#' SP <- param.simer(pop.ind = 1e2, ibd = TRUE, reprod.way = "randmate", pop.gen = 3, out = "simer")
+#' SP <- simer(SP)
+#' ibd <- cal.ibd(SP, gen = 3)
+#' head(ibd$ind)
+#' }
+cal.ibd <- function(SP, gen = NULL, ind = NULL, ncpus = 0, verbose = TRUE) {
+  
+  pop.geno <- SP$geno$pop.geno
+  incols <- SP$geno$incols
+  if (is.null(pop.geno)) {
+    stop("Please run genotype simulation before calculating IBD!")
+  }
+  if (is.null(gen)) { gen <- seq_along(pop.geno) }
+  pIbds <- lapply(pop.geno[gen], attr, which = "ibd")
+  if (any(sapply(pIbds, is.null))) {
+    stop("No IBD track is found, please set 'ibd' of genotype parameters to TRUE before simulation!")
+  }
+  
+  ibd.ind <- do.call(rbind, lapply(gen, function(i) {
+    gen.name <- names(pop.geno)[i]
+    n <- ncol(pop.geno[[i]]) / incols
+    pop <- SP$pheno$pop[[gen.name]]
+    if (!is.null(pop) && nrow(pop) == n) {
+      index <- pop$index
+    } else {
+      index <- seq_len(n)
+    }
+    return(data.frame(index = index, gen = gen.name))
+  }))
+  if (!is.null(ind)) {
+    inds <- match(ind, ibd.ind$index)
+    if (any(is.na(inds))) {
+      stop("Some individuals of 'ind' are not in 'gen'!")
+    }
+    ibd.ind <- ibd.ind[inds, ]
+  } else {
+    inds <- NULL
+  }
+  
+  logging.log(" Calculate IBD relationship of", nrow(ibd.ind), "individuals...\n", verbose = verbose)
+  ibd <- IbdKinship(pIbds = pIbds, inds = inds, threads = ncpus, verbose = verbose)
+  kin <- ibd$kin
+  rownames(kin) <- colnames(kin) <- ibd.ind$index
+  ibd.ind$F <- ibd$F
+  rownames(ibd.ind) <- NULL
+  
+  F.mean <- tapply(ibd.ind$F, ibd.ind$gen, mean)
+  F.sd <- tapply(ibd.ind$F, ibd.ind$gen, sd)
+  gen.names <- unique(ibd.ind$gen)
+  ibd.gen <- data.frame(gen = gen.names, meanF = as.numeric(F.mean[gen.names]), sdF = as.numeric(F.sd[gen.names]))
+  
+  return(list(kin = kin, ind = ibd.ind, gen = ibd.gen))
+}
+
+#' Pedigree inbreeding
+#' 
+#' Calculate the pedigree inbreeding coefficient F of every individual and every generation in the simulation by the algorithm of Meuwissen and Luo (1992), which only visits the ancestors of every individual.
+#' The coefficients of generations already calculated are kept, so that monitoring every generation only costs the new generation.
+#'
+#' Build date: Oct 17, 2026
+#' Last update: Oct 17, 2026
+#'
+#' @author Dong Yin
+#'
+#' @param SP a list of all simulation parameters.
+#' @param verbose whether to print detail.
+#'
+#' @return 
+#' the function returns a list containing
+#' \describe{
+#' \item{$pheno$pop.inbr}{a list of the pedigree inbreeding coefficients of the individuals of every generation.}
+#' }
+#' 
+#' @export
+#'
+#' @examples
+#' \donttest{
+#' SP <- param.simer(pop.ind = 1e2, reprod.way = "randmate", pop.gen = 3, out = "simer")
+#' SP <- simer(SP)
+#' SP <- cal.inbreed(SP)
+#' sapply(SP$pheno$pop.inbr, mean)
+#' }
+cal.inbreed <- function(SP, verbose = TRUE) {
+  
+  pop <- SP$pheno$pop
+  if (is.null(pop)) {
+    stop("Please run phenotype simulation before calculating inbreeding!")
+  }
+  pop.inbr <- SP$pheno$pop.inbr
+  
+  # generations already calculated, as a prefix of the pedigree
+  done <- 0
+  while (done < length(pop) && names(pop)[done + 1] %in% names(pop.inbr) &&
+         length(pop.inbr[[names(pop)[done + 1]]]) == nrow(pop[[done + 1]])) {
+    done <- done + 1
+  }
+  if (done == length(pop)) { return(SP) }
+  
+  id <- as.character(unlist(lapply(pop, function(x) x$index)))
+  sir <- match(as.character(unlist(lapply(pop, function(x) x$sir))), id)
+  dam <- match(as.character(unlist(lapply(pop, function(x) x$dam))), id)
+  sir[is.na(sir)] <- 0
+  dam[is.na(dam)] <- 0
+  # parents recorded after their offspring are taken as unknown
+  sir[sir >= seq_along(sir)] <- 0
+  dam[dam >= seq_along(dam)] <- 0
+  
+  F0 <- NULL
+  if (done > 0) { F0 <- unlist(pop.inbr[names(pop)[1:done]], use.names = FALSE) }
+  F <- PedInbreeding(sir = sir, dam = dam, F0 = F0)
+  
+  gen.ind <- rep(seq_along(pop), sapply(pop, nrow))
+  pop.inbr <- pop.inbr[names(pop)[seq_len(done)]]
+  if (is.null(pop.inbr)) { pop.inbr <- list() }
+  for (i in (done + 1):length(pop)) {
+    pop.inbr[[names(pop)[i]]] <- F[gen.ind == i]
+    logging.log(" Pedigree inbreeding of", names(pop)[i], ": mean F =", round(mean(F[gen.ind == i]), 4), "\n", verbose = verbose)
+  }
+  SP$pheno$pop.inbr <- pop.inbr
+  
+  return(SP)
+}
@@ -170,7 +170,7 @@ param.annot <- function(SP = NULL, ...) {
 #' Generate parameters for genotype data simulation.
 #' 
 #' Build date: Feb 21, 2022
-#' Last update: Jul 4, 2022
+#' Last update: Oct 17, 2026
 #'
 #' @author Dong Yin
 #'
@@ -187,6 +187,8 @@ param.annot <- function(SP = NULL, ...) {
 #' \item{$geno$prob}{the genotype code probability.}
 #' \item{$geno$rate.mut}{the mutation rate of the genotype data.}
 #' \item{$geno$cld}{whether to generate a complete LD genotype data when 'incols == 2'.}
+#' \item{$geno$monitor}{whether to calculate population genetic statistics and pedigree inbreeding of every generation.}
+#' \item{$geno$ibd}{whether to track the founder haplotypes of every individual, see cal.ibd.}
 #' }
 #' 
 #' @export
@@ -206,7 +208,9 @@ param.geno <- function(SP = NULL, ...) {
       pop.ind = 1e2,
       prob = NULL,
       rate.mut = list(qtn = 1e-8, snp = 1e-8),
-      cld = FALSE
+      cld = FALSE,
+      monitor = FALSE,
+      ibd = FALSE
     )
     
   } else {
@@ -16,7 +16,7 @@
 #' Population reproduction by different mate design.
 #'
 #' Build date: Nov 14, 2018
-#' Last update: Apr 29, 2022
+#' Last update: Oct 17, 2026
 #'
 #' @author Dong Yin
 #'
@@ -107,6 +107,12 @@ reproduces <- function(SP, ncpus = 0, verbose = TRUE) {
     stop("'reprod.way' should be 'clone', 'dh', 'selfpol', 'randmate', 'randexself', 'assort', 'disassort', '2waycro', '3waycro', '4waycro', 'backcro' or 'userped'!")
   }
 
+  # generations produced without genotype() such as clones
+  if (isTRUE(SP$geno$monitor)) {
+    SP <- cal.popgen(SP, ncpus = ncpus, verbose = FALSE)
+    SP <- cal.inbreed(SP, verbose = FALSE)
+  }
+  
   SP$global$useAllGeno <- TRUE
   SP <- phenotype(SP)
   
@@ -165,10 +171,28 @@ mate <- function(pop.geno, index.sir, index.dam, ncpus = 0) {
   gmt.comb[seq(2, length(gmt.comb), 2)] <- gmt.dam
   
   BigMat2BigMat(pop.geno.curr@address, pop.geno@address, colIdx = gmt.comb, threads = ncpus)
+  pop.geno.curr <- ibd.copy(pop.geno.curr, pop.geno, colIdx = gmt.comb)
   
   return(pop.geno.curr)
 }
 
+# carry the IBD track of the columns 'colIdx' of 'geno.from' (a genotype
+# matrix or a list of them put one after another) over to 'geno.to'
+ibd.copy <- function(geno.to, geno.from, colIdx = NULL) {
+  if (is.big.matrix(geno.from)) {
+    geno.from <- list(geno.from)
+  }
+  pIbds <- lapply(geno.from, attr, which = "ibd")
+  if (length(pIbds) == 0 | any(sapply(pIbds, is.null))) {
+    return(geno.to)
+  }
+  if (!is.null(colIdx)) {
+    colIdx <- as.integer(colIdx)
+  }
+  attr(geno.to, "ibd") <- IbdSubset(pIbds = pIbds, colIdx = colIdx)
+  return(geno.to)
+}
+
 #' Clone
 #' 
 #' Produce individuals by clone.
@@ -270,6 +294,7 @@ mate.clone <- function(SP, ncpus = 0, verbose = TRUE) {
     
     gmt.comb <- rep(gmt.comb, times = prog)
     BigMat2BigMat(pop.geno.curr@address, pop.geno@address, colIdx = gmt.comb, threads = ncpus)
+    pop.geno.curr <- ibd.copy(pop.geno.curr, pop.geno, colIdx = gmt.comb)
     
     ped.sir <- rep(ped.dam, times = prog)
     ped.dam <- rep(ped.dam, times = prog)
@@ -399,6 +424,7 @@ mate.dh <- function(SP, ncpus = 0, verbose = TRUE) {
     
     gmt.comb <- rep(rep(gmt.comb, each = 2), times = prog/2)
     BigMat2BigMat(pop.geno.curr@address, pop.geno@address, colIdx = gmt.comb, threads = ncpus)
+    pop.geno.curr <- ibd.copy(pop.geno.curr, pop.geno, colIdx = gmt.comb)
     
     ped.sir <- rep(rep(ped.dam, each = 2), times = prog/2)
     ped.dam <- rep(rep(ped.dam, each = 2), times = prog/2)
@@ -987,7 +1013,7 @@ mate.disassort <- function(SP, ncpus = 0, verbose = TRUE) {
 #' Produce individuals by two-way cross.
 #'
 #' Build date: Nov 14, 2018
-#' Last update: Apr 30, 2022
+#' Last update: Oct 17, 2026
 #'
 #' @author Dong Yin
 #'
@@ -1055,6 +1081,12 @@ mate.2waycro <- function(SP, ncpus = 0, verbose = TRUE) {
   count.ind <- c(count.ind, nrow(pop))
   logging.log(" After generation", 1, ",", sum(count.ind[1:1]), "individuals are generated...\n", verbose = verbose)
   
+  # Fst among breeds of the first generation
+  if (isTRUE(SP$geno$monitor)) {
+    breed <- cumsum(c(1, diff(pop$sex) != 0))
+    SP <- cal.popgen(SP, gen = length(SP$geno$pop.geno), group = breed, ncpus = ncpus, verbose = FALSE)
+  }
+  
   ped.sir <- pop.sel$sir
   ped.dam <- pop.sel$dam
   if (length(ped.sir) == 1) ped.sir <- rep(ped.sir, 2)
@@ -1095,7 +1127,7 @@ mate.2waycro <- function(SP, ncpus = 0, verbose = TRUE) {
 #' Produce individuals by three-way cross.
 #'
 #' Build date: Apr 11, 2022
-#' Last update: Apr 30, 2022
+#' Last update: Oct 17, 2026
 #'
 #' @author Dong Yin
 #'
@@ -1163,6 +1195,12 @@ mate.3waycro <- function(SP, ncpus = 0, verbose = TRUE) {
   count.ind <- c(count.ind, nrow(pop))
   logging.log(" After generation", 1, ",", sum(count.ind[1:1]), "individuals are generated...\n", verbose = verbose)
   
+  # Fst among breeds of the first generation
+  if (isTRUE(SP$geno$monitor)) {
+    breed <- cumsum(c(1, diff(pop$sex) != 0))
+    SP <- cal.popgen(SP, gen = length(SP$geno$pop.geno), group = breed, ncpus = ncpus, verbose = FALSE)
+  }
+  
   sex1 <- pop$sex
   sex2 <- c(1, sex1[-length(sex1)])
   sex.op <- which(sex1 != sex2)
@@ -1210,6 +1248,7 @@ mate.3waycro <- function(SP, ncpus = 0, verbose = TRUE) {
     type = "char")
   BigMat2BigMat(pop.geno.curr@address, pop.geno@address, colIdx = 1:ncol(pop.geno), threads = ncpus)
   BigMat2BigMat(pop.geno.curr@address, pop.geno.dam2@address, colIdx = 1:ncol(pop.geno.dam2), op = ncol(pop.geno)+1, threads = ncpus)
+  pop.geno.curr <- ibd.copy(pop.geno.curr, list(pop.geno, pop.geno.dam2))
   pop.sel <- SP$sel$pop.sel[[length(SP$sel$pop.sel)]]
   
   count.ind <- c(count.ind, nrow(pop))
@@ -1255,7 +1294,7 @@ mate.3waycro <- function(SP, ncpus = 0, verbose = TRUE) {
 #' Produce individuals by four-way cross.
 #'
 #' Build date: Apr 11, 2022
-#' Last update: Apr 30, 2022
+#' Last update: Oct 17, 2026
 #'
 #' @author Dong Yin
 #'
@@ -1323,6 +1362,12 @@ mate.4waycro <- function(SP, ncpus = 0, verbose = TRUE) {
   count.ind <- c(count.ind, nrow(pop))
   logging.log(" After generation", 1, ",", sum(count.ind[1:1]), "individuals are generated...\n", verbose = verbose)
   
+  # Fst among breeds of the first generation
+  if (isTRUE(SP$geno$monitor)) {
+    breed <- cumsum(c(1, diff(pop$sex) != 0))
+    SP <- cal.popgen(SP, gen = length(SP$geno$pop.geno), group = breed, ncpus = ncpus, verbose = FALSE)
+  }
+  
   sex1 <- pop$sex
   sex2 <- c(1, sex1[-length(sex1)])
   sex.op <- which(sex1 != sex2)
@@ -1359,6 +1404,7 @@ mate.4waycro <- function(SP, ncpus = 0, verbose = TRUE) {
     type = "char")
   BigMat2BigMat(pop.geno.curr@address, pop.geno.sir11@address, colIdx = 1:ncol(pop.geno.sir11), threads = ncpus)
   BigMat2BigMat(pop.geno.curr@address, pop.geno.dam22@address, colIdx = 1:ncol(pop.geno.dam22), op = ncol(pop.geno.sir11)+1, threads = ncpus)
+  pop.geno.curr <- ibd.copy(pop.geno.curr, list(pop.geno.sir11, pop.geno.dam22))
   
   sex <- rep(2, pop.ind)
   sex[sample(1:pop.ind, pop.ind * sex.rate)] <- 1
@@ -1538,6 +1584,7 @@ mate.backcro <- function(SP, ncpus = 0, verbose = TRUE) {
       type = "char")
     BigMat2BigMat(pop.geno@address, pop.geno.ori@address, colIdx = 1:ncol(pop.geno.ori), threads = ncpus)
     BigMat2BigMat(pop.geno@address, pop.geno.curr@address, colIdx = 1:ncol(pop.geno.curr), op = ncol(pop.geno.ori)+1, threads = ncpus)
+    pop.geno <- ibd.copy(pop.geno, list(pop.geno.ori, pop.geno.curr))
     pop.sel <- SP$sel$pop.sel[[length(SP$sel$pop.sel)]]
   }
   
@@ -1547,9 +1594,10 @@ mate.backcro <- function(SP, ncpus = 0, verbose = TRUE) {
 #' User-specified pedigree mating
 #'
 #' Produce individuals by user-specified pedigree mating.
+#' The genes are dropped through the whole pedigree at once, generation by generation in parallel, and all the offspring are put in one generation of the simulation with their generations in 'gen'.
 #'
 #' Build date: Apr 12, 2022
-#' Last update: Apr 30, 2022
+#' Last update: Oct 17, 2026
 #'
 #' @author Dong Yin
 #'
@@ -1597,69 +1645,140 @@ mate.userped <- function(SP, ncpus = 0, verbose = TRUE) {
   pop.geno.id <- pop[, 1]
   pop.geno <- SP$geno$pop.geno[[length(SP$geno$pop.geno)]]
   userped <- SP$reprod$userped
+  pop.map <- SP$map$pop.map
+  incols <- SP$geno$incols
+  rate.mut <- SP$geno$rate.mut
   
   # thanks to YinLL for sharing codes of pedigree sorting
   userped[is.na(userped)] <- "0"
   pedx <- as.matrix(userped)
-  pedx0 <- c(setdiff(pedx[, 2],pedx[, 1]), setdiff(pedx[, 3],pedx[, 1]))
-  pedx0 <- pedx0[pedx0 != 0]
+  pedx <- matrix(as.character(pedx), ncol = ncol(pedx))
+  pedx <- pedx[!duplicated(pedx[, 1]), , drop = FALSE]
+  
+  # generation order, parents missing as individuals being founders
+  ps <- PedigreeSort(pedx[, 1], pedx[, 2], pedx[, 3])
+  pedx <- rbind(cbind(ps$founder, "0", "0"), pedx)
+  flag.loop <- (ps$sirCleared | ps$damCleared)[ps$order]
+  pedx <- pedx[ps$order, , drop = FALSE]
+  if (any(flag.loop)) {
+    logging.log(" Some individuals in pedigree are in loops and not in mating process!\n They are", verbose = verbose)
+    logging.print(pedx[flag.loop, 1], verbose = verbose)
+  }
   
-  if(length(pedx0) != 0){
-    pedx <- rbind(cbind(pedx0, "0", "0"), pedx)
+  # parents coded over the base population and then the offspring, the
+  # offspring being those with both parents produced
+  nBase <- length(pop.geno.id)
+  code <- rep(NA, nrow(pedx))
+  code[ps$gen == 1 & !flag.loop] <- match(pedx[ps$gen == 1 & !flag.loop, 1], pop.geno.id)
+  off <- nBase
+  for (g in setdiff(unique(ps$gen), 1)) {
+    idx <- which(ps$gen == g & !flag.loop)
+    sir <- code[pmax(ps$sir[idx], 1)]
+    dam <- code[pmax(ps$dam[idx], 1)]
+    sir[ps$sir[idx] == 0] <- NA
+    dam[ps$dam[idx] == 0] <- NA
+    flag <- !is.na(sir) & !is.na(dam)
+    code[idx[flag]] <- off + seq_len(sum(flag))
+    off <- off + sum(flag)
+  }
+  flag.out <- is.na(code) & ps$gen > 1 & !flag.loop
+  if (any(flag.out)) {
+    logging.log(" Some individuals in pedigree are not in mating process!\n They are", verbose = verbose)
+    logging.print(pedx[flag.out, 1], verbose = verbose)
+  }
+  kid <- which(!is.na(code) & code > nBase)
+  pop.ind <- length(kid)
+  count.ind <- sum(!is.na(code) & code <= nBase)
+  logging.log(" After generation", 1, ",", count.ind, "individuals are generated...\n", verbose = verbose)
+  if (pop.ind == 0) { return(SP) }
+  
+  # random parts of meiosis, drawn here for the gene drop
+  layer <- ps$gen[kid]
+  hap.sir <- sample(c(0, 1), pop.ind, replace = TRUE)
+  hap.dam <- sample(c(0, 1), pop.ind, replace = TRUE)
+  Recom <- swap.ind <- integer(0)
+  if (!is.null(pop.map$Recom) & incols == 2) {
+    Recom <- which(pop.map$Recom %% 2 == 1)
+    swap.ind <- which(sample(c(0, 1), pop.ind, replace = TRUE) == 1)
+  }
+  row.mut <- col.mut <- integer(0)
+  if (!is.null(pop.map) & !is.null(rate.mut)) {
+    if (length(rate.mut) != 2) {
+      stop("Please input the mutation rate of SNP and QTN!")
+    }
+    pop.marker <- nrow(pop.geno)
+    qtn.index <- sort(unique(unlist((SP$map$qtn.index))))
+    snp.index <- (1:pop.marker)[-qtn.index]
+    for (g in unique(layer)) {
+      col.layer <- rep(2 * which(layer == g), each = 2) - c(1, 0)
+      spot.total <- pop.marker * length(col.layer)
+      num.mut.qtn <- round(spot.total * rate.mut[[1]])
+      num.mut.snp <- round(spot.total * rate.mut[[2]])
+      row.layer <- NULL
+      if (length(qtn.index) > 0 & num.mut.qtn > 0) {
+        row.layer <- c(row.layer, sample(qtn.index, num.mut.qtn, replace = TRUE))
+      }
+      if (length(snp.index) > 0 & num.mut.snp > 0) {
+        row.layer <- c(row.layer, sample(snp.index, num.mut.snp, replace = TRUE))
+      }
+      if (length(row.layer) > 0) {
+        row.mut <- c(row.mut, row.layer)
+        col.mut <- c(col.mut, col.layer[sample(length(col.layer), length(row.layer), replace = TRUE)])
+      }
+    }
   }
   
-  pedx <- pedx[!duplicated(pedx), ]
-  pedx <- pedx[!duplicated(pedx[, 1]), ]
-  
-  pedx1 <- pedx[ (pedx[, 2] == "0" & pedx[, 3] == "0"), ]
-  pedx2 <- pedx[!(pedx[, 2] == "0" & pedx[, 3] == "0"), ]
-  go <- TRUE
-  i <- 1
-  count.ind <- nrow(pedx1)
-  logging.log(" After generation", i, ",", sum(count.ind[1:i]), "individuals are generated...\n", verbose = verbose)
-  while(go == TRUE) {
-    i <- i + 1
-    Cpedx <- c(pedx1[, 1])
-    idx <- (pedx2[, 2] %in% Cpedx) & (pedx2[, 3] %in% Cpedx)
-    if (sum(idx) == 0) {
-      logging.log(" Some individuals in pedigree are not in mating process!\n They are", verbose = verbose)
-      logging.print(pedx2[, 1], verbose = verbose)
-      pedx2 <- pedx2[-c(1:nrow(pedx2)), ]
-      
-    } else {
-      index <- pedx2[, 1]
-      ped.sir <- pedx2[, 2]
-      ped.dam <- pedx2[, 3]
-      index.sir <- match(ped.sir, pop.geno.id)
-      index.dam <- match(ped.dam, pop.geno.id)
-      pop.ind <- length(index)
-      
-      pop.geno.curr <- mate(pop.geno = pop.geno, index.sir = index.sir, index.dam = index.dam, ncpus = ncpus)
-      
-      sex <- rep(0, length(index))
-      sex[index %in% unique(pedx[, 2])] <- 1
-      sex[index %in% unique(pedx[, 3])] <- 2
-      sex[sex == 0] <- sample(1:2, sum(sex == 0), replace = TRUE)
-      fam.temp <- getfam(ped.sir, ped.dam, pop$fam[length(pop$fam)]+1, "pm")
-      gen <- rep(pop$gen[1]+1, pop.ind)
-      pop.curr <- data.frame(index = index, gen = gen, fam = fam.temp[, 1], infam = fam.temp[, 2], sir = ped.sir, dam = ped.dam, sex = sex)
-      
-      SP$geno$pop.geno[[length(SP$geno$pop.geno) + 1]] <- pop.geno.curr
-      SP$pheno$pop[[length(SP$pheno$pop) + 1]] <- pop.curr
-      names(SP$geno$pop.geno)[length(SP$geno$pop.geno)] <- 
-        names(SP$pheno$pop)[length(SP$pheno$pop)] <- paste0("gen", length(SP$pheno$pop))
-      
-      ### genotype, phenotype, and selection ###
-      SP <- genotype(SP)
-      SP <- phenotype(SP)
-      
-      pedx1 <- rbind(pedx1, pedx2[idx, ])
-      pedx2 <- pedx2[!idx, ]
-      count.ind <- c(count.ind, pop.ind)
-      logging.log(" After generation", i, ",", sum(count.ind[1:i]), "individuals are generated...\n", verbose = verbose)
+  pop.geno.curr <- big.matrix(
+    nrow = nrow(pop.geno),
+    ncol = 2 * pop.ind,
+    init = 3,
+    type = typeof(pop.geno))
+  GeneDrop(pop.geno.curr@address, pop.geno@address, sir = code[ps$sir[kid]], dam = code[ps$dam[kid]], layer = layer, hapSir = hap.sir, hapDam = hap.dam, swapInd = swap.ind, recomRows = Recom, mutRow = row.mut, mutCol = col.mut, threads = ncpus)
+  
+  # IBD tracks follow the drop layer by layer
+  pIbd <- attr(pop.geno, "ibd")
+  if (!is.null(pIbd)) {
+    pIbds <- list(pIbd)
+    for (g in unique(layer)) {
+      idx <- which(layer == g)
+      gmt.comb <- c(rbind(2 * code[ps$sir[kid[idx]]] - 1 + hap.sir[idx], 2 * code[ps$dam[kid[idx]]] - 1 + hap.dam[idx]))
+      pIbd.curr <- IbdSubset(pIbds = pIbds, colIdx = as.integer(gmt.comb))
+      inds <- match(intersect(swap.ind, idx), idx)
+      if (length(Recom) > 0 & length(inds) > 0) {
+        IbdSwap(pIbd.curr, rows = Recom, inds = inds, threads = ncpus)
+      }
+      pIbds[[length(pIbds) + 1]] <- pIbd.curr
     }
-    if (any(class(pedx2) == "character")) pedx2 <- matrix(pedx2, 1)
-    if (dim(pedx2)[1] == 0) go = FALSE
+    attr(pop.geno.curr, "ibd") <- IbdSubset(pIbds = pIbds[-1])
+  }
+  
+  index <- pedx[kid, 1]
+  ped.sir <- pedx[kid, 2]
+  ped.dam <- pedx[kid, 3]
+  sex <- rep(0, length(index))
+  sex[index %in% unique(pedx[, 2])] <- 1
+  sex[index %in% unique(pedx[, 3])] <- 2
+  sex[sex == 0] <- sample(1:2, sum(sex == 0), replace = TRUE)
+  fam.temp <- getfam(ped.sir, ped.dam, pop$fam[length(pop$fam)]+1, "pm")
+  gen <- pop$gen[1] + layer - 1
+  pop.curr <- data.frame(index = index, gen = gen, fam = fam.temp[, 1], infam = fam.temp[, 2], sir = ped.sir, dam = ped.dam, sex = sex)
+  
+  SP$geno$pop.geno[[length(SP$geno$pop.geno) + 1]] <- pop.geno.curr
+  SP$pheno$pop[[length(SP$pheno$pop) + 1]] <- pop.curr
+  names(SP$geno$pop.geno)[length(SP$geno$pop.geno)] <- 
+    names(SP$pheno$pop)[length(SP$pheno$pop)] <- paste0("gen", length(SP$pheno$pop))
+  
+  # the offspring skip genotype(), so that they are monitored here
+  if (isTRUE(SP$geno$monitor)) {
+    SP <- cal.popgen(SP, gen = length(SP$geno$pop.geno), ncpus = ncpus, verbose = FALSE)
+    SP <- cal.inbreed(SP, verbose = FALSE)
+  }
+  
+  ### phenotype of all the offspring at once ###
+  SP <- phenotype(SP)
+  for (g in unique(layer)) {
+    count.ind <- c(count.ind, sum(layer == g))
+    logging.log(" After generation", length(count.ind), ",", sum(count.ind), "individuals are generated...\n", verbose = verbose)
   }
   
   return(SP)
@@ -1670,7 +1789,7 @@ mate.userped <- function(SP, ncpus = 0, verbose = TRUE) {
 #' Get indice of family and within-family
 #'
 #' Build date: Nov 14, 2018
-#' Last update: Apr 30, 2022
+#' Last update: Oct 17, 2026
 #'
 #' @author Dong Yin
 #'
@@ -1679,7 +1798,7 @@ mate.userped <- function(SP, ncpus = 0, verbose = TRUE) {
 #' @param fam.op the initial index of family indice.
 #' @param mode "pat": paternal mode; "mat": maternal mode; "pm": paternal and maternal mode.
 #' 
-#' @return a matrix with family indice and within-family indice.
+#' @return a matrix with family indice and within-family indice, with the attributes 'size' (the individual number of every family), 'order' (the individuals grouped by family), and 'offset' (the start of every family in 'order', 0-based).
 #' 
 #' @export
 #'
@@ -1689,39 +1808,20 @@ mate.userped <- function(SP, ncpus = 0, verbose = TRUE) {
 #' fam <- getfam(sir = s, dam = d, fam.op = 1, mode = "pm")
 #' fam
 getfam <- function(sir, dam, fam.op, mode = c("pat", "mat", "pm")) {
-  fam <- rep(0, length(sir))
-  infam <- rep(0, length(sir))
-  if (mode == "pat") {
-    uni.sir <- unique(sir)
-    for (i in 1:length(uni.sir)) {
-      flag <- sir == uni.sir[i]
-      flag[is.na(flag)] <- FALSE
-      fam[flag] <- fam.op + i - 1
-      infam[flag] <- 1:sum(flag)
-    }
-  } else if (mode == "mat") {
-    uni.dam <- unique(dam)
-    for (i in 1:length(uni.dam)) {
-      flag <- dam == uni.dam[i]
-      flag[is.na(flag)] <- FALSE
-      fam[flag] <- fam.op + i - 1
-      infam[flag] <- 1:sum(flag)
-    }
-  } else if (mode == "pm") {
-    uni.sd <- unique(cbind(sir, dam))
-    for (i in 1:nrow(uni.sd)) {
-      flag1 <- sir == uni.sd[i, 1]
-      flag2 <- dam == uni.sd[i, 2]
-      flag <- flag1 & flag2
-      flag[is.na(flag)] <- FALSE
-      fam[flag] <- fam.op + i - 1
-      infam[flag] <- 1:sum(flag)
-    }
-  } else {
+  if (length(mode) != 1 || !(mode %in% c("pat", "mat", "pm"))) {
     stop("Please input right mode!")
   }
+  
+  # families by a hash of the parents in a single pass
+  fam.idx <- FamilyIndex(sir = as.character(sir), dam = as.character(dam), famOp = fam.op, mode = mode)
+  fam <- fam.idx$fam
+  infam <- fam.idx$infam
+  fam.res <- cbind(fam, infam)
+  attr(fam.res, "size") <- fam.idx$size
+  attr(fam.res, "offset") <- fam.idx$offset
+  attr(fam.res, "order") <- fam.idx$order
 
-  return(cbind(fam, infam))
+  return(fam.res)
 }
 
 #' Individual number per generation
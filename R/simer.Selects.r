@@ -16,7 +16,7 @@
 #' Select individuals by combination of selection method and criterion.
 #'
 #' Build date: Sep 8, 2018
-#' Last update: Apr 30, 2022
+#' Last update: Oct 17, 2026
 #'
 #' @author Dong Yin
 #'
@@ -103,51 +103,23 @@ selects <- function(SP = NULL, verbose = TRUE) {
     
     ### single trait selection ###
     if (length(phe.pos) == 1) {
-      num.infam <- tapply(rep(1, pop.ind), pop$fam, sum)
       if (sel.single == "comb") {
-        # calculate A matrix
-        A.cal <- function(s, d) {
-          n <- length(s)
-          A <- matrix(0, nrow = n, ncol = n)
-          for (x in 1:n) {
-            if (s[x] > 0 && d[x] > 0) {
-              A[x, x] <- 1 + 0.5 * A[s[x], d[x]];
-            } else {
-              A[x, x] <- 1;
-            }
-            if (x == n) next
-            for (y in (x+1):n) {
-              axy <- 0
-              if (s[y] > 0) axy <- axy + 0.5 * A[x, s[y]]
-              if (d[y] > 0) axy <- axy + 0.5 * A[x, d[y]]
-              A[x, y] <- axy
-              A[y, x] <- axy
-            }
-          }
-          return(A)
-        }
         # calculate average family correlation coefficient
         cal.r <- function(pop, pop.total) {
           if (nrow(pop.total) == nrow(pop)) { return(0.01) }
-          sir <- pop.total$sir
-          sir <- as.numeric(sir[sir != "NA"])
-          dam <- pop.total$dam
-          dam <- as.numeric(dam[dam != "NA"])
-          A.mat <- A.cal(sir, dam)
-          cor.ani <- pop[!duplicated(pop$fam), ]$index
-          cor.r <- rep(0, length(cor.ani))
-          for (i in 1:length(cor.ani)) {
-            cor.r[i] <- A.mat[cor.ani[i], cor.ani[i]+1]
-          }
+          sir <- match(pop.total$sir, pop.total$index, nomatch = 0)
+          dam <- match(pop.total$dam, pop.total$index, nomatch = 0)
+          cor.ani <- match(pop[!duplicated(pop$fam), ]$index, pop.total$index)
+          cor.r <- PedRelationPairs(sir = sir, dam = dam, i = cor.ani, j = cor.ani + 1)
           cor.r <- mean(cor.r)
           return(cor.r)
         }
         cor.r <- cal.r(pop, pop.total)
         # calculate combination selection method
         cal.comb <- function(pop) {
-          pop.ind <- length(pop$index)
-          num.infam <- tapply(rep(1, pop.ind), pop$fam, sum)
-          pf <- rep(tapply(pop[, phe.pos], pop$fam, mean), num.infam)
+          fam <- getfam(pop$fam, pop$fam, 1, "pat")
+          num.infam <- attr(fam, "size")
+          pf <- (rowsum(pop[, phe.pos], fam[, 1])[, 1] / num.infam)[fam[, 1]]
           cor.n <- num.infam[[1]]
           
           if (length(num.infam) == 1) {
@@ -185,9 +157,10 @@ selects <- function(SP = NULL, verbose = TRUE) {
         
         # calculate pf and pw
         cal.pfw <- function(pop) {
-          pop.ind <- length(pop$index)
-          num.infam <- tapply(rep(1, pop.ind), pop$fam, sum)
-          pf <- rep(tapply(pop[, phe.pos], pop$fam, mean), num.infam)
+          # family means by the families of getfam()
+          fam <- getfam(pop$fam, pop$fam, 1, "pat")
+          num.infam <- attr(fam, "size")
+          pf <- (rowsum(pop[, phe.pos], fam[, 1])[, 1] / num.infam)[fam[, 1]]
           pw <- pop[, phe.pos] - pf
           pfw <- cbind(pf, pw)
           return(pfw)
@@ -286,3 +259,52 @@ selects <- function(SP = NULL, verbose = TRUE) {
   names(SP$sel$pop.sel)[length(SP$sel$pop.sel)] <- paste0("gen", length(SP$sel$pop.sel))
 	return(SP)
 }
+
+#' Inverse relationship matrix
+#' 
+#' Build the inverse of the numerator relationship matrix of a pedigree directly by the rules of Henderson (1976), the Mendelian sampling variances being adjusted for the inbreeding of the parents, so that the relationship matrix itself is never formed.
+#'
+#' Build date: Oct 17, 2026
+#' Last update: Oct 17, 2026
+#'
+#' @author Dong Yin
+#'
+#' @param ped a data frame or matrix of the pedigree, with the columns 'index', 'sir', and 'dam' as in 'SP$pheno$pop', or with the individuals, sires, and dams in the first three columns; unknown parents are "0" or NA.
+#' @param verbose whether to print detail.
+#' 
+#' @return a symmetric sparse matrix (dsCMatrix) of the inverse relationship matrix, with the individuals in generation order as dimnames.
+#' 
+#' @export
+#'
+#' @examples
+#' ped <- data.frame(index = 1:6, sir = c(0, 0, 1, 1, 3, 3), dam = c(0, 0, 2, 0, 4, 2))
+#' Ainv <- cal.Ainv(ped)
+#' Ainv
+cal.Ainv <- function(ped, verbose = TRUE) {
+  
+  ped <- as.data.frame(ped, stringsAsFactors = FALSE)
+  if (all(c("index", "sir", "dam") %in% names(ped))) {
+    ped <- ped[, c("index", "sir", "dam")]
+  } else if (ncol(ped) < 3) {
+    stop("'ped' should contain the individuals, sires, and dams!")
+  }
+  ped <- sapply(ped[, 1:3], as.character)
+  if (!is.matrix(ped)) { ped <- matrix(ped, 1) }
+  ped[is.na(ped) | ped == ""] <- "0"
+  ped <- ped[!duplicated(ped[, 1]), , drop = FALSE]
+  
+  # generation order, parents missing as individuals being founders
+  ps <- PedigreeSort(ped[, 1], ped[, 2], ped[, 3])
+  id <- c(ps$founder, ped[, 1])
+  flag.loop <- ps$sirCleared | ps$damCleared
+  if (any(flag.loop)) {
+    logging.log(" Some individuals in pedigree are in loops, and their parents are taken as unknown!\n They are", verbose = verbose)
+    logging.print(id[flag.loop], verbose = verbose)
+  }
+  id <- id[ps$order]
+  
+  Ainv <- PedInverse(sir = ps$sir, dam = ps$dam)
+  Ainv <- Matrix::sparseMatrix(i = Ainv$i, p = Ainv$p, x = Ainv$x, dims = rep(length(id), 2), dimnames = list(id, id), symmetric = TRUE, index1 = FALSE)
+  
+  return(Ainv)
+}
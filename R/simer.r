@@ -50,9 +50,7 @@ simer <- function(SP) {
 # TODO: how to generate inbreeding sirs and uninbreeding dams
 # TODO: optcontri.sel  
 # TODO: add superior limit of homo
-# TODO: add inbreeding coefficient
 # TODO: add true block distribution
-# TODO: inbreeding change in every generations
 # TODO: breeding literature from ZhenST
 # TODO: remove one column genotype
 # TODO: data converter of simer
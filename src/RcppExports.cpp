@@ -38,6 +38,20 @@ BEGIN_RCPP
     return R_NilValue;
 END_RCPP
 }
+// BedSubset
+void BedSubset(std::string bed_in, std::string bed_out, long ind, IntegerVector rowIdx, bool verbose);
+RcppExport SEXP _simer_BedSubset(SEXP bed_inSEXP, SEXP bed_outSEXP, SEXP indSEXP, SEXP rowIdxSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type bed_in(bed_inSEXP);
+    Rcpp::traits::input_parameter< std::string >::type bed_out(bed_outSEXP);
+    Rcpp::traits::input_parameter< long >::type ind(indSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type rowIdx(rowIdxSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    BedSubset(bed_in, bed_out, ind, rowIdx, verbose);
+    return R_NilValue;
+END_RCPP
+}
 // emma_kinship
 arma::mat emma_kinship(SEXP pBigMat, int threads, bool verbose);
 RcppExport SEXP _simer_emma_kinship(SEXP pBigMatSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
@@ -69,6 +83,41 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// GenoFilterChunk
+List GenoFilterChunk(const SEXP pBigMat, Nullable<IntegerVector> keepInds, Nullable<double> filterGeno, Nullable<double> filterHWE, Nullable<double> filterMind, Nullable<double> filterMAF, double memLimit, int threads, bool verbose);
+RcppExport SEXP _simer_GenoFilterChunk(SEXP pBigMatSEXP, SEXP keepIndsSEXP, SEXP filterGenoSEXP, SEXP filterHWESEXP, SEXP filterMindSEXP, SEXP filterMAFSEXP, SEXP memLimitSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< Nullable<IntegerVector> >::type keepInds(keepIndsSEXP);
+    Rcpp::traits::input_parameter< Nullable<double> >::type filterGeno(filterGenoSEXP);
+    Rcpp::traits::input_parameter< Nullable<double> >::type filterHWE(filterHWESEXP);
+    Rcpp::traits::input_parameter< Nullable<double> >::type filterMind(filterMindSEXP);
+    Rcpp::traits::input_parameter< Nullable<double> >::type filterMAF(filterMAFSEXP);
+    Rcpp::traits::input_parameter< double >::type memLimit(memLimitSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(GenoFilterChunk(pBigMat, keepInds, filterGeno, filterHWE, filterMind, filterMAF, memLimit, threads, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// BigMatSubset
+void BigMatSubset(const SEXP pBigMat, const SEXP pBigmat, IntegerVector rowIdx, IntegerVector colIdx, double memLimit, int threads, bool verbose);
+RcppExport SEXP _simer_BigMatSubset(SEXP pBigMatSEXP, SEXP pBigmatSEXP, SEXP rowIdxSEXP, SEXP colIdxSEXP, SEXP memLimitSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< const SEXP >::type pBigmat(pBigmatSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type rowIdx(rowIdxSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type colIdx(colIdxSEXP);
+    Rcpp::traits::input_parameter< double >::type memLimit(memLimitSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    BigMatSubset(pBigMat, pBigmat, rowIdx, colIdx, memLimit, threads, verbose);
+    return R_NilValue;
+END_RCPP
+}
 // Mat2BigMat
 void Mat2BigMat(const SEXP pBigMat, IntegerMatrix mat, Nullable<IntegerVector> colIdx, int op, int threads);
 RcppExport SEXP _simer_Mat2BigMat(SEXP pBigMatSEXP, SEXP matSEXP, SEXP colIdxSEXP, SEXP opSEXP, SEXP threadsSEXP) {
@@ -113,6 +162,174 @@ BEGIN_RCPP
     return R_NilValue;
 END_RCPP
 }
+// GenoStat
+List GenoStat(const SEXP pBigMat, int incols, Nullable<IntegerVector> group, int nBin, int threads);
+RcppExport SEXP _simer_GenoStat(SEXP pBigMatSEXP, SEXP incolsSEXP, SEXP groupSEXP, SEXP nBinSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< int >::type incols(incolsSEXP);
+    Rcpp::traits::input_parameter< Nullable<IntegerVector> >::type group(groupSEXP);
+    Rcpp::traits::input_parameter< int >::type nBin(nBinSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(GenoStat(pBigMat, incols, group, nBin, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GeneDrop
+void GeneDrop(const SEXP pBigMat, const SEXP pFounder, IntegerVector sir, IntegerVector dam, IntegerVector layer, IntegerVector hapSir, IntegerVector hapDam, IntegerVector swapInd, IntegerVector recomRows, IntegerVector mutRow, IntegerVector mutCol, int threads);
+RcppExport SEXP _simer_GeneDrop(SEXP pBigMatSEXP, SEXP pFounderSEXP, SEXP sirSEXP, SEXP damSEXP, SEXP layerSEXP, SEXP hapSirSEXP, SEXP hapDamSEXP, SEXP swapIndSEXP, SEXP recomRowsSEXP, SEXP mutRowSEXP, SEXP mutColSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< const SEXP >::type pFounder(pFounderSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type sir(sirSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type dam(damSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type layer(layerSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type hapSir(hapSirSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type hapDam(hapDamSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type swapInd(swapIndSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type recomRows(recomRowsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type mutRow(mutRowSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type mutCol(mutColSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    GeneDrop(pBigMat, pFounder, sir, dam, layer, hapSir, hapDam, swapInd, recomRows, mutRow, mutCol, threads);
+    return R_NilValue;
+END_RCPP
+}
+// GrmOperatorCreate
+SEXP GrmOperatorCreate(SEXP pBigMat, NumericVector ref, std::string method, double memLimit, int threads);
+RcppExport SEXP _simer_GrmOperatorCreate(SEXP pBigMatSEXP, SEXP refSEXP, SEXP methodSEXP, SEXP memLimitSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type ref(refSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< double >::type memLimit(memLimitSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(GrmOperatorCreate(pBigMat, ref, method, memLimit, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GrmOperatorPacked
+SEXP GrmOperatorPacked(std::string kin_file);
+RcppExport SEXP _simer_GrmOperatorPacked(SEXP kin_fileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type kin_file(kin_fileSEXP);
+    rcpp_result_gen = Rcpp::wrap(GrmOperatorPacked(kin_file));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GrmOperatorDim
+double GrmOperatorDim(SEXP pOp);
+RcppExport SEXP _simer_GrmOperatorDim(SEXP pOpSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pOp(pOpSEXP);
+    rcpp_result_gen = Rcpp::wrap(GrmOperatorDim(pOp));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GrmOperatorMult
+NumericMatrix GrmOperatorMult(SEXP pOp, NumericMatrix X, int threads);
+RcppExport SEXP _simer_GrmOperatorMult(SEXP pOpSEXP, SEXP XSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pOp(pOpSEXP);
+    Rcpp::traits::input_parameter< NumericMatrix >::type X(XSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(GrmOperatorMult(pOp, X, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GrmPCA
+List GrmPCA(List pBigMats, std::string method, int incols, int k, int iter, int oversample, double memLimit, int threads, bool verbose);
+RcppExport SEXP _simer_GrmPCA(SEXP pBigMatsSEXP, SEXP methodSEXP, SEXP incolsSEXP, SEXP kSEXP, SEXP iterSEXP, SEXP oversampleSEXP, SEXP memLimitSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type pBigMats(pBigMatsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< int >::type incols(incolsSEXP);
+    Rcpp::traits::input_parameter< int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< int >::type iter(iterSEXP);
+    Rcpp::traits::input_parameter< int >::type oversample(oversampleSEXP);
+    Rcpp::traits::input_parameter< double >::type memLimit(memLimitSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(GrmPCA(pBigMats, method, incols, k, iter, oversample, memLimit, threads, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// IbdFounder
+SEXP IbdFounder(double m, double nhap, double offset);
+RcppExport SEXP _simer_IbdFounder(SEXP mSEXP, SEXP nhapSEXP, SEXP offsetSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< double >::type m(mSEXP);
+    Rcpp::traits::input_parameter< double >::type nhap(nhapSEXP);
+    Rcpp::traits::input_parameter< double >::type offset(offsetSEXP);
+    rcpp_result_gen = Rcpp::wrap(IbdFounder(m, nhap, offset));
+    return rcpp_result_gen;
+END_RCPP
+}
+// IbdSubset
+SEXP IbdSubset(List pIbds, Nullable<IntegerVector> colIdx);
+RcppExport SEXP _simer_IbdSubset(SEXP pIbdsSEXP, SEXP colIdxSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type pIbds(pIbdsSEXP);
+    Rcpp::traits::input_parameter< Nullable<IntegerVector> >::type colIdx(colIdxSEXP);
+    rcpp_result_gen = Rcpp::wrap(IbdSubset(pIbds, colIdx));
+    return rcpp_result_gen;
+END_RCPP
+}
+// IbdSwap
+void IbdSwap(SEXP pIbd, IntegerVector rows, IntegerVector inds, int threads);
+RcppExport SEXP _simer_IbdSwap(SEXP pIbdSEXP, SEXP rowsSEXP, SEXP indsSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pIbd(pIbdSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type rows(rowsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type inds(indsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    IbdSwap(pIbd, rows, inds, threads);
+    return R_NilValue;
+END_RCPP
+}
+// IbdSegments
+DataFrame IbdSegments(SEXP pIbd);
+RcppExport SEXP _simer_IbdSegments(SEXP pIbdSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pIbd(pIbdSEXP);
+    rcpp_result_gen = Rcpp::wrap(IbdSegments(pIbd));
+    return rcpp_result_gen;
+END_RCPP
+}
+// IbdKinship
+List IbdKinship(List pIbds, Nullable<IntegerVector> inds, int threads, bool verbose);
+RcppExport SEXP _simer_IbdKinship(SEXP pIbdsSEXP, SEXP indsSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type pIbds(pIbdsSEXP);
+    Rcpp::traits::input_parameter< Nullable<IntegerVector> >::type inds(indsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(IbdKinship(pIbds, inds, threads, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
 // hasNA
 bool hasNA(SEXP pBigMat, const int threads);
 RcppExport SEXP _simer_hasNA(SEXP pBigMatSEXP, SEXP threadsSEXP) {
@@ -140,9 +357,295 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// grm_kinship
+arma::mat grm_kinship(SEXP pBigMat, std::string method, double memLimit, int threads, bool verbose);
+RcppExport SEXP _simer_grm_kinship(SEXP pBigMatSEXP, SEXP methodSEXP, SEXP memLimitSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< double >::type memLimit(memLimitSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(grm_kinship(pBigMat, method, memLimit, threads, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// KinshipRef
+NumericVector KinshipRef(SEXP pBigMat, std::string method, int threads);
+RcppExport SEXP _simer_KinshipRef(SEXP pBigMatSEXP, SEXP methodSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(KinshipRef(pBigMat, method, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// KinshipTiled
+void KinshipTiled(SEXP pKin, SEXP pBigMat, NumericVector ref, std::string method, double memLimit, int threads, bool verbose);
+RcppExport SEXP _simer_KinshipTiled(SEXP pKinSEXP, SEXP pBigMatSEXP, SEXP refSEXP, SEXP methodSEXP, SEXP memLimitSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pKin(pKinSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type ref(refSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< double >::type memLimit(memLimitSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    KinshipTiled(pKin, pBigMat, ref, method, memLimit, threads, verbose);
+    return R_NilValue;
+END_RCPP
+}
+// KinshipTiledPacked
+void KinshipTiledPacked(std::string kin_file, SEXP pBigMat, NumericVector ref, std::string method, double memLimit, int threads, bool verbose);
+RcppExport SEXP _simer_KinshipTiledPacked(SEXP kin_fileSEXP, SEXP pBigMatSEXP, SEXP refSEXP, SEXP methodSEXP, SEXP memLimitSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type kin_file(kin_fileSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type ref(refSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< double >::type memLimit(memLimitSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    KinshipTiledPacked(kin_file, pBigMat, ref, method, memLimit, threads, verbose);
+    return R_NilValue;
+END_RCPP
+}
+// KinshipAppend
+void KinshipAppend(SEXP pKin, SEXP pOldMat, SEXP pNewMat, NumericVector ref, std::string method, double memLimit, int threads, bool verbose);
+RcppExport SEXP _simer_KinshipAppend(SEXP pKinSEXP, SEXP pOldMatSEXP, SEXP pNewMatSEXP, SEXP refSEXP, SEXP methodSEXP, SEXP memLimitSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pKin(pKinSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type pOldMat(pOldMatSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type pNewMat(pNewMatSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type ref(refSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< double >::type memLimit(memLimitSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    KinshipAppend(pKin, pOldMat, pNewMat, ref, method, memLimit, threads, verbose);
+    return R_NilValue;
+END_RCPP
+}
+// KinshipAppendPacked
+void KinshipAppendPacked(std::string kin_file, SEXP pOldMat, SEXP pNewMat, NumericVector ref, std::string method, double memLimit, int threads, bool verbose);
+RcppExport SEXP _simer_KinshipAppendPacked(SEXP kin_fileSEXP, SEXP pOldMatSEXP, SEXP pNewMatSEXP, SEXP refSEXP, SEXP methodSEXP, SEXP memLimitSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type kin_file(kin_fileSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type pOldMat(pOldMatSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type pNewMat(pNewMatSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type ref(refSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< double >::type memLimit(memLimitSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    KinshipAppendPacked(kin_file, pOldMat, pNewMat, ref, method, memLimit, threads, verbose);
+    return R_NilValue;
+END_RCPP
+}
+// KinshipGrow
+void KinshipGrow(std::string bin_file, double n, double k, bool verbose);
+RcppExport SEXP _simer_KinshipGrow(SEXP bin_fileSEXP, SEXP nSEXP, SEXP kSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type bin_file(bin_fileSEXP);
+    Rcpp::traits::input_parameter< double >::type n(nSEXP);
+    Rcpp::traits::input_parameter< double >::type k(kSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    KinshipGrow(bin_file, n, k, verbose);
+    return R_NilValue;
+END_RCPP
+}
+// LDWindow
+List LDWindow(SEXP pBigMat, IntegerVector chrom, NumericVector pos, int incols, bool haplotype, int winSNP, double winBP, double binSize, bool keepPairs, int threads, bool verbose);
+RcppExport SEXP _simer_LDWindow(SEXP pBigMatSEXP, SEXP chromSEXP, SEXP posSEXP, SEXP incolsSEXP, SEXP haplotypeSEXP, SEXP winSNPSEXP, SEXP winBPSEXP, SEXP binSizeSEXP, SEXP keepPairsSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type chrom(chromSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type pos(posSEXP);
+    Rcpp::traits::input_parameter< int >::type incols(incolsSEXP);
+    Rcpp::traits::input_parameter< bool >::type haplotype(haplotypeSEXP);
+    Rcpp::traits::input_parameter< int >::type winSNP(winSNPSEXP);
+    Rcpp::traits::input_parameter< double >::type winBP(winBPSEXP);
+    Rcpp::traits::input_parameter< double >::type binSize(binSizeSEXP);
+    Rcpp::traits::input_parameter< bool >::type keepPairs(keepPairsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(LDWindow(pBigMat, chrom, pos, incols, haplotype, winSNP, winBP, binSize, keepPairs, threads, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// LDRegion
+List LDRegion(SEXP pBigMat, IntegerVector rowIdx, int incols, bool haplotype, int threads, bool verbose);
+RcppExport SEXP _simer_LDRegion(SEXP pBigMatSEXP, SEXP rowIdxSEXP, SEXP incolsSEXP, SEXP haplotypeSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type rowIdx(rowIdxSEXP);
+    Rcpp::traits::input_parameter< int >::type incols(incolsSEXP);
+    Rcpp::traits::input_parameter< bool >::type haplotype(haplotypeSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(LDRegion(pBigMat, rowIdx, incols, haplotype, threads, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// LDPrune
+IntegerVector LDPrune(SEXP pBigMat, IntegerVector chrom, Nullable<IntegerVector> rowIdx, Nullable<IntegerVector> colIdx, int incols, int winSNP, int step, double r2Thres, int threads, bool verbose);
+RcppExport SEXP _simer_LDPrune(SEXP pBigMatSEXP, SEXP chromSEXP, SEXP rowIdxSEXP, SEXP colIdxSEXP, SEXP incolsSEXP, SEXP winSNPSEXP, SEXP stepSEXP, SEXP r2ThresSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type chrom(chromSEXP);
+    Rcpp::traits::input_parameter< Nullable<IntegerVector> >::type rowIdx(rowIdxSEXP);
+    Rcpp::traits::input_parameter< Nullable<IntegerVector> >::type colIdx(colIdxSEXP);
+    Rcpp::traits::input_parameter< int >::type incols(incolsSEXP);
+    Rcpp::traits::input_parameter< int >::type winSNP(winSNPSEXP);
+    Rcpp::traits::input_parameter< int >::type step(stepSEXP);
+    Rcpp::traits::input_parameter< double >::type r2Thres(r2ThresSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(LDPrune(pBigMat, chrom, rowIdx, colIdx, incols, winSNP, step, r2Thres, threads, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// LDPruneBed
+IntegerVector LDPruneBed(std::string bed_file, int ind, IntegerVector chrom, Nullable<IntegerVector> rowIdx, int winSNP, int step, double r2Thres, int threads, bool verbose);
+RcppExport SEXP _simer_LDPruneBed(SEXP bed_fileSEXP, SEXP indSEXP, SEXP chromSEXP, SEXP rowIdxSEXP, SEXP winSNPSEXP, SEXP stepSEXP, SEXP r2ThresSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type bed_file(bed_fileSEXP);
+    Rcpp::traits::input_parameter< int >::type ind(indSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type chrom(chromSEXP);
+    Rcpp::traits::input_parameter< Nullable<IntegerVector> >::type rowIdx(rowIdxSEXP);
+    Rcpp::traits::input_parameter< int >::type winSNP(winSNPSEXP);
+    Rcpp::traits::input_parameter< int >::type step(stepSEXP);
+    Rcpp::traits::input_parameter< double >::type r2Thres(r2ThresSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(LDPruneBed(bed_file, ind, chrom, rowIdx, winSNP, step, r2Thres, threads, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// LDClump
+List LDClump(SEXP pBigMat, IntegerVector chrom, NumericVector pos, NumericVector pval, int incols, double p1, double p2, double r2Thres, double winBP, int threads, bool verbose);
+RcppExport SEXP _simer_LDClump(SEXP pBigMatSEXP, SEXP chromSEXP, SEXP posSEXP, SEXP pvalSEXP, SEXP incolsSEXP, SEXP p1SEXP, SEXP p2SEXP, SEXP r2ThresSEXP, SEXP winBPSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type chrom(chromSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type pos(posSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
+    Rcpp::traits::input_parameter< int >::type incols(incolsSEXP);
+    Rcpp::traits::input_parameter< double >::type p1(p1SEXP);
+    Rcpp::traits::input_parameter< double >::type p2(p2SEXP);
+    Rcpp::traits::input_parameter< double >::type r2Thres(r2ThresSEXP);
+    Rcpp::traits::input_parameter< double >::type winBP(winBPSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(LDClump(pBigMat, chrom, pos, pval, incols, p1, p2, r2Thres, winBP, threads, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// LDClumpBed
+List LDClumpBed(std::string bed_file, int ind, IntegerVector chrom, NumericVector pos, NumericVector pval, double p1, double p2, double r2Thres, double winBP, int threads, bool verbose);
+RcppExport SEXP _simer_LDClumpBed(SEXP bed_fileSEXP, SEXP indSEXP, SEXP chromSEXP, SEXP posSEXP, SEXP pvalSEXP, SEXP p1SEXP, SEXP p2SEXP, SEXP r2ThresSEXP, SEXP winBPSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type bed_file(bed_fileSEXP);
+    Rcpp::traits::input_parameter< int >::type ind(indSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type chrom(chromSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type pos(posSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
+    Rcpp::traits::input_parameter< double >::type p1(p1SEXP);
+    Rcpp::traits::input_parameter< double >::type p2(p2SEXP);
+    Rcpp::traits::input_parameter< double >::type r2Thres(r2ThresSEXP);
+    Rcpp::traits::input_parameter< double >::type winBP(winBPSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(LDClumpBed(bed_file, ind, chrom, pos, pval, p1, p2, r2Thres, winBP, threads, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// PackedDim
+double PackedDim(std::string kin_file);
+RcppExport SEXP _simer_PackedDim(SEXP kin_fileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type kin_file(kin_fileSEXP);
+    rcpp_result_gen = Rcpp::wrap(PackedDim(kin_file));
+    return rcpp_result_gen;
+END_RCPP
+}
+// PackedRows
+NumericMatrix PackedRows(std::string kin_file, IntegerVector rows, int threads);
+RcppExport SEXP _simer_PackedRows(SEXP kin_fileSEXP, SEXP rowsSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type kin_file(kin_fileSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type rows(rowsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(PackedRows(kin_file, rows, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// PackedPairs
+NumericVector PackedPairs(std::string kin_file, IntegerVector i, IntegerVector j);
+RcppExport SEXP _simer_PackedPairs(SEXP kin_fileSEXP, SEXP iSEXP, SEXP jSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type kin_file(kin_fileSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type i(iSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type j(jSEXP);
+    rcpp_result_gen = Rcpp::wrap(PackedPairs(kin_file, i, j));
+    return rcpp_result_gen;
+END_RCPP
+}
+// PackedFromBig
+void PackedFromBig(SEXP pBigMat, std::string kin_file, int threads);
+RcppExport SEXP _simer_PackedFromBig(SEXP pBigMatSEXP, SEXP kin_fileSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< std::string >::type kin_file(kin_fileSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    PackedFromBig(pBigMat, kin_file, threads);
+    return R_NilValue;
+END_RCPP
+}
+// PackedToBig
+void PackedToBig(std::string kin_file, SEXP pBigMat, int threads);
+RcppExport SEXP _simer_PackedToBig(SEXP kin_fileSEXP, SEXP pBigMatSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type kin_file(kin_fileSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    PackedToBig(kin_file, pBigMat, threads);
+    return R_NilValue;
+END_RCPP
+}
 // PedigreeCorrector
-DataFrame PedigreeCorrector(const SEXP pBigMat, StringVector rawGenoID, DataFrame rawPed, Nullable<StringVector> candSirID, Nullable<StringVector> candDamID, double exclThres, double assignThres, Nullable<NumericVector> birthDate, int threads, bool verbose);
-RcppExport SEXP _simer_PedigreeCorrector(SEXP pBigMatSEXP, SEXP rawGenoIDSEXP, SEXP rawPedSEXP, SEXP candSirIDSEXP, SEXP candDamIDSEXP, SEXP exclThresSEXP, SEXP assignThresSEXP, SEXP birthDateSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+DataFrame PedigreeCorrector(const SEXP pBigMat, StringVector rawGenoID, DataFrame rawPed, Nullable<StringVector> candSirID, Nullable<StringVector> candDamID, double exclThres, double assignThres, Nullable<NumericVector> birthDate, int threads, bool verbose, std::string confFile, int sketchSize);
+RcppExport SEXP _simer_PedigreeCorrector(SEXP pBigMatSEXP, SEXP rawGenoIDSEXP, SEXP rawPedSEXP, SEXP candSirIDSEXP, SEXP candDamIDSEXP, SEXP exclThresSEXP, SEXP assignThresSEXP, SEXP birthDateSEXP, SEXP threadsSEXP, SEXP verboseSEXP, SEXP confFileSEXP, SEXP sketchSizeSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -156,7 +659,166 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< Nullable<NumericVector> >::type birthDate(birthDateSEXP);
     Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
     Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
-    rcpp_result_gen = Rcpp::wrap(PedigreeCorrector(pBigMat, rawGenoID, rawPed, candSirID, candDamID, exclThres, assignThres, birthDate, threads, verbose));
+    Rcpp::traits::input_parameter< std::string >::type confFile(confFileSEXP);
+    Rcpp::traits::input_parameter< int >::type sketchSize(sketchSizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(PedigreeCorrector(pBigMat, rawGenoID, rawPed, candSirID, candDamID, exclThres, assignThres, birthDate, threads, verbose, confFile, sketchSize));
+    return rcpp_result_gen;
+END_RCPP
+}
+// PedigreeExpand
+List PedigreeExpand(CharacterMatrix ped);
+RcppExport SEXP _simer_PedigreeExpand(SEXP pedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterMatrix >::type ped(pedSEXP);
+    rcpp_result_gen = Rcpp::wrap(PedigreeExpand(ped));
+    return rcpp_result_gen;
+END_RCPP
+}
+// PedigreeSort
+List PedigreeSort(StringVector id, StringVector sir, StringVector dam);
+RcppExport SEXP _simer_PedigreeSort(SEXP idSEXP, SEXP sirSEXP, SEXP damSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< StringVector >::type id(idSEXP);
+    Rcpp::traits::input_parameter< StringVector >::type sir(sirSEXP);
+    Rcpp::traits::input_parameter< StringVector >::type dam(damSEXP);
+    rcpp_result_gen = Rcpp::wrap(PedigreeSort(id, sir, dam));
+    return rcpp_result_gen;
+END_RCPP
+}
+// FamilyIndex
+List FamilyIndex(StringVector sir, StringVector dam, double famOp, std::string mode);
+RcppExport SEXP _simer_FamilyIndex(SEXP sirSEXP, SEXP damSEXP, SEXP famOpSEXP, SEXP modeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< StringVector >::type sir(sirSEXP);
+    Rcpp::traits::input_parameter< StringVector >::type dam(damSEXP);
+    Rcpp::traits::input_parameter< double >::type famOp(famOpSEXP);
+    Rcpp::traits::input_parameter< std::string >::type mode(modeSEXP);
+    rcpp_result_gen = Rcpp::wrap(FamilyIndex(sir, dam, famOp, mode));
+    return rcpp_result_gen;
+END_RCPP
+}
+// PedRelationPairs
+NumericVector PedRelationPairs(IntegerVector sir, IntegerVector dam, IntegerVector i, IntegerVector j);
+RcppExport SEXP _simer_PedRelationPairs(SEXP sirSEXP, SEXP damSEXP, SEXP iSEXP, SEXP jSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< IntegerVector >::type sir(sirSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type dam(damSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type i(iSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type j(jSEXP);
+    rcpp_result_gen = Rcpp::wrap(PedRelationPairs(sir, dam, i, j));
+    return rcpp_result_gen;
+END_RCPP
+}
+// PedRelationMult
+NumericMatrix PedRelationMult(IntegerVector sir, IntegerVector dam, NumericMatrix X, int threads);
+RcppExport SEXP _simer_PedRelationMult(SEXP sirSEXP, SEXP damSEXP, SEXP XSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< IntegerVector >::type sir(sirSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type dam(damSEXP);
+    Rcpp::traits::input_parameter< NumericMatrix >::type X(XSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(PedRelationMult(sir, dam, X, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// PedInbreeding
+NumericVector PedInbreeding(IntegerVector sir, IntegerVector dam, Nullable<NumericVector> F0);
+RcppExport SEXP _simer_PedInbreeding(SEXP sirSEXP, SEXP damSEXP, SEXP F0SEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< IntegerVector >::type sir(sirSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type dam(damSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type F0(F0SEXP);
+    rcpp_result_gen = Rcpp::wrap(PedInbreeding(sir, dam, F0));
+    return rcpp_result_gen;
+END_RCPP
+}
+// PedInverse
+List PedInverse(IntegerVector sir, IntegerVector dam, Nullable<NumericVector> F);
+RcppExport SEXP _simer_PedInverse(SEXP sirSEXP, SEXP damSEXP, SEXP FSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< IntegerVector >::type sir(sirSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type dam(damSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type F(FSEXP);
+    rcpp_result_gen = Rcpp::wrap(PedInverse(sir, dam, F));
+    return rcpp_result_gen;
+END_RCPP
+}
+// KinEigen
+List KinEigen(arma::mat K, std::string eig_file, bool verbose);
+RcppExport SEXP _simer_KinEigen(SEXP KSEXP, SEXP eig_fileSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::mat >::type K(KSEXP);
+    Rcpp::traits::input_parameter< std::string >::type eig_file(eig_fileSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(KinEigen(K, eig_file, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// KinEigenLoad
+SEXP KinEigenLoad(std::string eig_file, arma::mat K);
+RcppExport SEXP _simer_KinEigenLoad(SEXP eig_fileSEXP, SEXP KSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type eig_file(eig_fileSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type K(KSEXP);
+    rcpp_result_gen = Rcpp::wrap(KinEigenLoad(eig_file, K));
+    return rcpp_result_gen;
+END_RCPP
+}
+// EmmaReml
+List EmmaReml(arma::vec y, arma::mat X, arma::vec d, arma::mat U, int ngrids, double llim, double ulim, double tol);
+RcppExport SEXP _simer_EmmaReml(SEXP ySEXP, SEXP XSEXP, SEXP dSEXP, SEXP USEXP, SEXP ngridsSEXP, SEXP llimSEXP, SEXP ulimSEXP, SEXP tolSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< arma::vec >::type y(ySEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type X(XSEXP);
+    Rcpp::traits::input_parameter< arma::vec >::type d(dSEXP);
+    Rcpp::traits::input_parameter< arma::mat >::type U(USEXP);
+    Rcpp::traits::input_parameter< int >::type ngrids(ngridsSEXP);
+    Rcpp::traits::input_parameter< double >::type llim(llimSEXP);
+    Rcpp::traits::input_parameter< double >::type ulim(ulimSEXP);
+    Rcpp::traits::input_parameter< double >::type tol(tolSEXP);
+    rcpp_result_gen = Rcpp::wrap(EmmaReml(y, X, d, U, ngrids, llim, ulim, tol));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ROHCall
+List ROHCall(SEXP pBigMat, IntegerVector chrom, NumericVector pos, int incols, int minSNP, double minBP, int maxHet, double maxGap, double maxDensity, bool keepSegments, int threads, bool verbose);
+RcppExport SEXP _simer_ROHCall(SEXP pBigMatSEXP, SEXP chromSEXP, SEXP posSEXP, SEXP incolsSEXP, SEXP minSNPSEXP, SEXP minBPSEXP, SEXP maxHetSEXP, SEXP maxGapSEXP, SEXP maxDensitySEXP, SEXP keepSegmentsSEXP, SEXP threadsSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type pBigMat(pBigMatSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type chrom(chromSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type pos(posSEXP);
+    Rcpp::traits::input_parameter< int >::type incols(incolsSEXP);
+    Rcpp::traits::input_parameter< int >::type minSNP(minSNPSEXP);
+    Rcpp::traits::input_parameter< double >::type minBP(minBPSEXP);
+    Rcpp::traits::input_parameter< int >::type maxHet(maxHetSEXP);
+    Rcpp::traits::input_parameter< double >::type maxGap(maxGapSEXP);
+    Rcpp::traits::input_parameter< double >::type maxDensity(maxDensitySEXP);
+    Rcpp::traits::input_parameter< bool >::type keepSegments(keepSegmentsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< bool >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(ROHCall(pBigMat, chrom, pos, incols, minSNP, minBP, maxHet, maxGap, maxDensity, keepSegments, threads, verbose));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -164,14 +826,58 @@ END_RCPP
 static const R_CallMethodDef CallEntries[] = {
     {"_simer_write_bfile", (DL_FUNC) &_simer_write_bfile, 4},
     {"_simer_read_bfile", (DL_FUNC) &_simer_read_bfile, 5},
+    {"_simer_BedSubset", (DL_FUNC) &_simer_BedSubset, 5},
     {"_simer_emma_kinship", (DL_FUNC) &_simer_emma_kinship, 3},
     {"_simer_GenoFilter", (DL_FUNC) &_simer_GenoFilter, 8},
+    {"_simer_GenoFilterChunk", (DL_FUNC) &_simer_GenoFilterChunk, 9},
+    {"_simer_BigMatSubset", (DL_FUNC) &_simer_BigMatSubset, 7},
     {"_simer_Mat2BigMat", (DL_FUNC) &_simer_Mat2BigMat, 5},
     {"_simer_BigMat2BigMat", (DL_FUNC) &_simer_BigMat2BigMat, 5},
     {"_simer_GenoMixer", (DL_FUNC) &_simer_GenoMixer, 7},
+    {"_simer_GenoStat", (DL_FUNC) &_simer_GenoStat, 5},
+    {"_simer_GeneDrop", (DL_FUNC) &_simer_GeneDrop, 12},
+    {"_simer_GrmOperatorCreate", (DL_FUNC) &_simer_GrmOperatorCreate, 5},
+    {"_simer_GrmOperatorPacked", (DL_FUNC) &_simer_GrmOperatorPacked, 1},
+    {"_simer_GrmOperatorDim", (DL_FUNC) &_simer_GrmOperatorDim, 1},
+    {"_simer_GrmOperatorMult", (DL_FUNC) &_simer_GrmOperatorMult, 3},
+    {"_simer_GrmPCA", (DL_FUNC) &_simer_GrmPCA, 9},
+    {"_simer_IbdFounder", (DL_FUNC) &_simer_IbdFounder, 3},
+    {"_simer_IbdSubset", (DL_FUNC) &_simer_IbdSubset, 2},
+    {"_simer_IbdSwap", (DL_FUNC) &_simer_IbdSwap, 4},
+    {"_simer_IbdSegments", (DL_FUNC) &_simer_IbdSegments, 1},
+    {"_simer_IbdKinship", (DL_FUNC) &_simer_IbdKinship, 4},
     {"_simer_hasNA", (DL_FUNC) &_simer_hasNA, 2},
     {"_simer_hasNABed", (DL_FUNC) &_simer_hasNABed, 5},
-    {"_simer_PedigreeCorrector", (DL_FUNC) &_simer_PedigreeCorrector, 10},
+    {"_simer_grm_kinship", (DL_FUNC) &_simer_grm_kinship, 5},
+    {"_simer_KinshipRef", (DL_FUNC) &_simer_KinshipRef, 3},
+    {"_simer_KinshipTiled", (DL_FUNC) &_simer_KinshipTiled, 7},
+    {"_simer_KinshipTiledPacked", (DL_FUNC) &_simer_KinshipTiledPacked, 7},
+    {"_simer_KinshipAppend", (DL_FUNC) &_simer_KinshipAppend, 8},
+    {"_simer_KinshipAppendPacked", (DL_FUNC) &_simer_KinshipAppendPacked, 8},
+    {"_simer_KinshipGrow", (DL_FUNC) &_simer_KinshipGrow, 4},
+    {"_simer_LDWindow", (DL_FUNC) &_simer_LDWindow, 11},
+    {"_simer_LDRegion", (DL_FUNC) &_simer_LDRegion, 6},
+    {"_simer_LDPrune", (DL_FUNC) &_simer_LDPrune, 10},
+    {"_simer_LDPruneBed", (DL_FUNC) &_simer_LDPruneBed, 9},
+    {"_simer_LDClump", (DL_FUNC) &_simer_LDClump, 11},
+    {"_simer_LDClumpBed", (DL_FUNC) &_simer_LDClumpBed, 11},
+    {"_simer_PackedDim", (DL_FUNC) &_simer_PackedDim, 1},
+    {"_simer_PackedRows", (DL_FUNC) &_simer_PackedRows, 3},
+    {"_simer_PackedPairs", (DL_FUNC) &_simer_PackedPairs, 3},
+    {"_simer_PackedFromBig", (DL_FUNC) &_simer_PackedFromBig, 3},
+    {"_simer_PackedToBig", (DL_FUNC) &_simer_PackedToBig, 3},
+    {"_simer_PedigreeCorrector", (DL_FUNC) &_simer_PedigreeCorrector, 12},
+    {"_simer_PedigreeExpand", (DL_FUNC) &_simer_PedigreeExpand, 1},
+    {"_simer_PedigreeSort", (DL_FUNC) &_simer_PedigreeSort, 3},
+    {"_simer_FamilyIndex", (DL_FUNC) &_simer_FamilyIndex, 4},
+    {"_simer_PedRelationPairs", (DL_FUNC) &_simer_PedRelationPairs, 4},
+    {"_simer_PedRelationMult", (DL_FUNC) &_simer_PedRelationMult, 4},
+    {"_simer_PedInbreeding", (DL_FUNC) &_simer_PedInbreeding, 3},
+    {"_simer_PedInverse", (DL_FUNC) &_simer_PedInverse, 3},
+    {"_simer_KinEigen", (DL_FUNC) &_simer_KinEigen, 3},
+    {"_simer_KinEigenLoad", (DL_FUNC) &_simer_KinEigenLoad, 2},
+    {"_simer_EmmaReml", (DL_FUNC) &_simer_EmmaReml, 8},
+    {"_simer_ROHCall", (DL_FUNC) &_simer_ROHCall, 12},
     {NULL, NULL, 0}
 };
 
@@ -0,0 +1,245 @@
+#ifndef SIMER_BITPACK_H_
+#define SIMER_BITPACK_H_
+
+#include <Rcpp.h>
+#include <stdint.h>
+#include <vector>
+#include <bigmemory/BigMatrix.h>
+#include <bigmemory/MatrixAccessor.hpp>
+#include "simer_omp.h"
+#include "packed.h"
+
+// [[Rcpp::plugins(cpp11)]]
+
+static inline int popcnt64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static inline int ctz64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(x);
+#else
+  int n = 0;
+  while (!(x & 1)) { x >>= 1; n++; }
+  return n;
+#endif
+}
+
+static inline size_t popcnt(const uint64_t *x, size_t nw) {
+  size_t s = 0;
+  for (size_t w = 0; w < nw; w++) { s += popcnt64(x[w]); }
+  return s;
+}
+
+static inline size_t popcnt_and(const uint64_t *x, const uint64_t *y, size_t nw) {
+  size_t s = 0;
+  for (size_t w = 0; w < nw; w++) { s += popcnt64(x[w] & y[w]); }
+  return s;
+}
+
+static inline size_t popcnt_and3(const uint64_t *x, const uint64_t *y, const uint64_t *z, size_t nw) {
+  size_t s = 0;
+  for (size_t w = 0; w < nw; w++) { s += popcnt64(x[w] & y[w] & z[w]); }
+  return s;
+}
+
+// Bit-packed genotype of a set of markers, one bit per unit (individual or
+// haplotype), 64 units per word, markers stored one after another.
+//   a: dosage >= 1 (haplotype: allele is 1)
+//   b: dosage == 2 (always empty for haplotypes)
+//   v: genotype is observed
+// a and b are cleared wherever v is cleared, so that a dosage is a + b.
+struct BitGeno {
+  size_t nmrk, nunit, nw;
+  bool hap;
+  std::vector<uint64_t> a, b, v;
+  std::vector<unsigned char> full;  // marker has no missing genotype
+
+  BitGeno() : nmrk(0), nunit(0), nw(0), hap(false) {}
+
+  void init(size_t m, size_t u, bool h) {
+    nmrk = m; nunit = u; hap = h;
+    nw = (u + 63) / 64;
+    a.assign(m * nw, 0);
+    b.assign(h ? 0 : m * nw, 0);
+    v.assign(m * nw, 0);
+    full.assign(m, 1);
+  }
+
+  uint64_t* A(size_t k) { return &a[k * nw]; }
+  uint64_t* B(size_t k) { return hap ? NULL : &b[k * nw]; }
+  uint64_t* V(size_t k) { return &v[k * nw]; }
+  const uint64_t* A(size_t k) const { return &a[k * nw]; }
+  const uint64_t* B(size_t k) const { return hap ? NULL : &b[k * nw]; }
+  const uint64_t* V(size_t k) const { return &v[k * nw]; }
+};
+
+// Pack the markers 'rows' of a big.matrix (markers x columns); any code
+// other than 0/1/2 (0/1 for haplotypes) is treated as missing.
+//   hap = true : every column is a haplotype coded 0/1;
+//   incols = 1 : every column is an individual coded 0/1/2;
+//   incols = 2 : two adjacent haplotype columns are summed to a dosage.
+// 'units' selects columns (individuals when incols = 2, 0-based), all of
+// them if empty. Columns are read one after another so that every read is
+// sequential. bitgeno_fill never throws, so that it can run inside an
+// OpenMP region once bitgeno_check has passed.
+static inline void bitgeno_check(Rcpp::XPtr<BigMatrix> pMat, int incols, bool hap) {
+  if (!hap && incols == 2 && pMat->ncol() % 2 != 0) {
+    Rcpp::stop("the column number of genotype should be even when 'incols' is 2!");
+  }
+}
+
+template <typename T>
+void bitgeno_fill(BitGeno &g, Rcpp::XPtr<BigMatrix> pMat, const std::vector<size_t> &rows, const std::vector<size_t> &units, int incols, bool hap) {
+  MatrixAccessor<T> bigm = MatrixAccessor<T>(*pMat);
+  size_t ncol = pMat->ncol();
+  size_t m = rows.size();
+  size_t nunit = units.size() > 0 ? units.size() : ((hap || incols == 1) ? ncol : ncol / 2);
+  g.init(m, nunit, hap);
+  size_t nw = g.nw;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t w = 0; w < nw; w++) {
+    size_t uEnd = std::min(nunit, (w + 1) * 64);
+    for (size_t u = w * 64; u < uEnd; u++) {
+      uint64_t bit = 1ULL << (u % 64);
+      size_t c = units.size() > 0 ? units[u] : u;
+      if (hap || incols == 1) {
+        T *col = bigm[c];
+        for (size_t k = 0; k < m; k++) {
+          T x = col[rows[k]];
+          if (x == 0) {
+            g.v[k * nw + w] |= bit;
+          } else if (x == 1) {
+            g.v[k * nw + w] |= bit;
+            g.a[k * nw + w] |= bit;
+          } else if (x == 2 && !hap) {
+            g.v[k * nw + w] |= bit;
+            g.a[k * nw + w] |= bit;
+            g.b[k * nw + w] |= bit;
+          }
+        }
+      } else {
+        T *col1 = bigm[2 * c];
+        T *col2 = bigm[2 * c + 1];
+        for (size_t k = 0; k < m; k++) {
+          T x1 = col1[rows[k]], x2 = col2[rows[k]];
+          if ((x1 == 0 || x1 == 1) && (x2 == 0 || x2 == 1)) {
+            g.v[k * nw + w] |= bit;
+            if (x1 + x2 >= 1) { g.a[k * nw + w] |= bit; }
+            if (x1 + x2 == 2) { g.b[k * nw + w] |= bit; }
+          }
+        }
+      }
+    }
+  }
+
+  // padding bits of the last word are never observed
+  #pragma omp parallel for schedule(static)
+  for (size_t k = 0; k < m; k++) {
+    size_t s = popcnt(g.V(k), nw);
+    g.full[k] = (s == nunit);
+  }
+}
+
+template <typename T>
+void bitgeno_pack(BitGeno &g, Rcpp::XPtr<BigMatrix> pMat, const std::vector<size_t> &rows, const std::vector<size_t> &units, int incols, bool hap, int threads=0) {
+  omp_setup(threads);
+  bitgeno_check(pMat, incols, hap);
+  bitgeno_fill<T>(g, pMat, rows, units, incols, hap);
+}
+
+template <typename T>
+void bitgeno_pack(BitGeno &g, Rcpp::XPtr<BigMatrix> pMat, const std::vector<size_t> &rows, int incols, bool hap, int threads=0) {
+  std::vector<size_t> units;
+  bitgeno_pack<T>(g, pMat, rows, units, incols, hap, threads);
+}
+
+template <typename T>
+void bitgeno_pack(BitGeno &g, Rcpp::XPtr<BigMatrix> pMat, int incols, bool hap, int threads=0) {
+  std::vector<size_t> rows(pMat->nrow());
+  for (size_t k = 0; k < rows.size(); k++) { rows[k] = k; }
+  bitgeno_pack<T>(g, pMat, rows, incols, hap, threads);
+}
+
+// Pack the markers 'rows' of a PLINK .bed file of 'nind' individuals into
+// dosage planes. A .bed row is 2 bits per individual: 00 -> 2, 10 -> 1,
+// 11 -> 0 and 01 -> missing, the same coding as read_bfile.
+// bitgeno_read_bed never throws and returns false if the file cannot be
+// read, so that it can run inside an OpenMP region, every thread with its
+// own file; bitgeno_check_bed checks the file beforehand.
+static inline void bitgeno_check_bed(std::string bed_file, size_t nind, size_t nmrk) {
+  FILE *fin = fopen(bed_file.c_str(), "rb");
+  if (fin == NULL) {
+    Rcpp::stop("cannot open file: %s", bed_file.c_str());
+  }
+  size_t nbyte = (nind + 3) / 4;
+  unsigned char last;
+  bool ok = nmrk == 0 || (simer_fseek(fin, 3 + (int64_t)nmrk * nbyte - 1) == 0 && fread(&last, 1, 1, fin) == 1);
+  fclose(fin);
+  if (!ok) {
+    Rcpp::stop("the .bed file is shorter than expected: %s", bed_file.c_str());
+  }
+}
+
+static inline bool bitgeno_read_bed(BitGeno &g, std::string bed_file, size_t nind, const std::vector<size_t> &rows) {
+  size_t m = rows.size();
+  size_t nbyte = (nind + 3) / 4;
+  g.init(m, nind, false);
+  size_t nw = g.nw;
+
+  FILE *fin = fopen(bed_file.c_str(), "rb");
+  if (fin == NULL) { return false; }
+  std::vector<unsigned char> buffer(nbyte);
+  for (size_t k = 0; k < m; k++) {
+    if (simer_fseek(fin, 3 + (int64_t)rows[k] * nbyte) != 0 || fread(buffer.data(), 1, nbyte, fin) != nbyte) {
+      fclose(fin);
+      return false;
+    }
+    uint64_t *a = g.A(k), *b = g.B(k), *v = g.V(k);
+    for (size_t i = 0; i < nind; i++) {
+      int code = (buffer[i / 4] >> (2 * (i % 4))) & 0x03;
+      uint64_t bit = 1ULL << (i % 64);
+      size_t w = i / 64;
+      if (code == 3) {
+        v[w] |= bit;
+      } else if (code == 2) {
+        v[w] |= bit; a[w] |= bit;
+      } else if (code == 0) {
+        v[w] |= bit; a[w] |= bit; b[w] |= bit;
+      }
+    }
+    g.full[k] = (popcnt(v, nw) == nind);
+  }
+  fclose(fin);
+  return true;
+}
+
+// Square tiles covering the upper triangle (including the diagonal) of an
+// n x n pair space, to be handed out to threads with a dynamic schedule.
+struct PairTile {
+  size_t r0, r1, c0, c1;
+};
+
+static inline std::vector<PairTile> upper_tiles(size_t n, size_t tile) {
+  std::vector<PairTile> tiles;
+  if (tile == 0) { tile = 1; }
+  for (size_t r0 = 0; r0 < n; r0 += tile) {
+    for (size_t c0 = r0; c0 < n; c0 += tile) {
+      PairTile t;
+      t.r0 = r0; t.r1 = std::min(n, r0 + tile);
+      t.c0 = c0; t.c1 = std::min(n, c0 + tile);
+      tiles.push_back(t);
+    }
+  }
+  return tiles;
+}
+
+#endif
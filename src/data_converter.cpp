@@ -1,4 +1,5 @@
 #include "simer_omp.h"
+#include "packed.h"
 #include <boost/bind.hpp>
 #include <boost/algorithm/string.hpp>
 #include <bigmemory/BigMatrix.h>
@@ -174,3 +175,53 @@ void read_bfile(std::string bed_file, SEXP pBigMat, long maxLine, int threads=0,
     throw Rcpp::exception("unknown type detected for big.matrix object!");
   }
 }
+
+// [[Rcpp::export]]
+void BedSubset(std::string bed_in, std::string bed_out, long ind, IntegerVector rowIdx, bool verbose=true) {
+  // check input
+  if (!boost::ends_with(bed_in, ".bed")) {
+    bed_in += ".bed";
+  }
+  if (!boost::ends_with(bed_out, ".bed")) {
+    bed_out += ".bed";
+  }
+  
+  // define
+  long n = ind / 4;  // 4 individual = 1 bit
+  if (ind % 4 != 0) 
+    n++;
+  vector<char> buffer(n);
+  
+  // open file
+  FILE *fin, *fout;
+  fin = fopen(bed_in.c_str(), "rb");
+  if (fin == NULL) {
+    Rcpp::stop("cannot open file: %s", bed_in.c_str());
+  }
+  fout = fopen(bed_out.c_str(), "wb");
+  if (fout == NULL) {
+    fclose(fin);
+    Rcpp::stop("cannot open file: %s", bed_out.c_str());
+  }
+  
+  // progress bar
+  Progress progress(rowIdx.size(), verbose);
+  
+  // magic number of bfile
+  const unsigned char magic_bytes[] = { 0x6c, 0x1b, 0x01 };
+  fwrite((char*)magic_bytes, 1, 3, fout);
+  
+  // copy the selected rows (1-based) in the given order
+  for (int i = 0; i < rowIdx.size(); i++) {
+    if (simer_fseek(fin, 3 + (int64_t)(rowIdx[i] - 1) * n) != 0 || static_cast<long>(fread(buffer.data(), 1, n, fin)) != n) {
+      fclose(fin);
+      fclose(fout);
+      Rcpp::stop("'rowIdx' is out of bound of file: %s", bed_in.c_str());
+    }
+    fwrite(buffer.data(), 1, n, fout);
+    progress.increment();
+  }
+  fclose(fin);
+  fclose(fout);
+  return;
+}
@@ -1,7 +1,4 @@
-#include <RcppArmadillo.h>
-#include <bigmemory/BigMatrix.h>
-#include <bigmemory/MatrixAccessor.hpp>
-#include "simer_omp.h"
+#include "kinship.h"
 #include "MinimalProgressBar.h"
 
 // [[Rcpp::plugins(cpp11)]]
@@ -57,45 +54,57 @@ template <typename T>
 arma::mat emma_kinship(XPtr<BigMatrix> pMat, int threads = 0, bool verbose=true) {
   omp_setup(threads);
   
-  int i, j, k, m = pMat->nrow(), n = pMat->ncol();
-  double s;
+  size_t m = pMat->nrow(), n = pMat->ncol();
 
-  arma::mat K(n, n, fill::ones);
+  arma::mat K(n, n, fill::zeros);
 
   MatrixAccessor<T> bigm = MatrixAccessor<T>(*pMat);
 
   arma::vec rowMeans = BigRowMean(pMat, threads);
+  vector<T*> cols(n);
+  for (size_t i = 0; i < n; i++) { cols[i] = bigm[i]; }
+
+  // markers are packed block by block, so that the planes of all
+  // individuals stay small whatever the marker number is
+  size_t blockWords = 256;
+  size_t blockSize = blockWords * 64;
+  size_t nBlock = (m + blockSize - 1) / blockSize;
+  vector<PairTile> tiles = upper_tiles(n, 64);
+  EmmaPlanes P;
+  vector<uint64_t> M1;
 
   MinimalProgressBar pb;
-  Progress p(n, verbose, pb);
+  Progress p(nBlock, verbose, pb);
 
   if (verbose) { Rcout << " Computing EMMA Kinship Matrix..." << endl; }
 
-  #pragma omp parallel for private(i, j, k, s)
-  for (i = 0; i < n; i++) {
-    for (j = i+1; j < n; j++) {
-      s = 0;
-      for (k = 0; k < m; k++) {
-        if (bigm[i][k] == bigm[j][k]) {
-          s = s + 1;
-        } else {
-          if ((bigm[i][k] == 1) || (bigm[j][k] == 1)) {
-            if (rowMeans[k] == 1) {
-              if ((bigm[i][k] + bigm[j][k]) == 1) {
-                s = s + 1;
-              }
-            } else {
-              s = s + 0.5;
-            }
-          }
+  for (size_t b = 0; b < nBlock; b++) {
+    size_t k0 = b * blockSize, k1 = min(m, k0 + blockSize);
+    emma_pack<T>(cols, k0, k1, P);
+    emma_m1(rowMeans, k0, k1, M1);
+
+    // square tiles of the upper triangle keep the work of every thread even
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t tt = 0; tt < tiles.size(); tt++) {
+      const PairTile &tile = tiles[tt];
+      for (size_t i = tile.r0; i < tile.r1; i++) {
+        for (size_t j = max(i + 1, tile.c0); j < tile.c1; j++) {
+          K(i, j) += emma_ibs2(P, i, P, j, M1);
         }
       }
-      K(i, j) = s / m;
-      K(j, i) = K(i, j);
     }
     if ( ! Progress::check_abort() ) { p.increment(); }
   }
 
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t j = 0; j < n; j++) {
+    K(j, j) = 1;
+    for (size_t i = 0; i < j; i++) {
+      K(i, j) = K(i, j) / (2.0 * m);
+      K(j, i) = K(i, j);
+    }
+  }
+
   return K;
 }
 
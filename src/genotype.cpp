@@ -1,5 +1,7 @@
 #include <RcppArmadillo.h>
 #include "simer_omp.h"
+#include "simer_madvise.h"
+#include "MinimalProgressBar.h"
 #include <bigmemory/BigMatrix.h>
 #include <bigmemory/MatrixAccessor.hpp>
 #include <progress.hpp>
@@ -355,6 +357,285 @@ List GenoFilter(const SEXP pBigMat, Nullable<IntegerVector> keepInds=R_NilValue,
   }
 }
 
+template<typename T>
+List GenoFilterChunk(XPtr<BigMatrix> pMat, double NA_C, Nullable<IntegerVector> keepInds=R_NilValue, Nullable<double> filterGeno=R_NilValue, Nullable<double> filterHWE=R_NilValue, Nullable<double> filterMind=R_NilValue, Nullable<double> filterMAF=R_NilValue, double memLimit=256, int threads=0, bool verbose=true) {
+  omp_setup(threads);
+
+  MatrixAccessor<T> bigm = MatrixAccessor<T>(*pMat);
+  size_t m = pMat->nrow(), nAll = pMat->ncol();
+  size_t i, j, b, k;
+
+  IntegerVector keepCols;
+  if (keepInds.isNull()) {
+    keepCols = seq(0, nAll - 1);
+  } else {
+    keepCols = as<IntegerVector>(keepInds);
+    keepCols = keepCols - 1;
+    if (keepCols.size() > 0 && (min(keepCols) < 0 || max(keepCols) >= (int)nAll)) {
+      Rcpp::stop("'keepInds' is out of bound!");
+    }
+  }
+  double n = keepCols.size();
+
+  double fgeno = 0, fhwe = 0, fmaf = 0, fmind = 0;
+  if (filterGeno.isNotNull()) { fgeno = as<double>(filterGeno); }
+  if (filterHWE.isNotNull() ) { fhwe  = as<double>(filterHWE ); }
+  if (filterMAF.isNotNull() ) { fmaf  = as<double>(filterMAF); }
+  if (filterMind.isNotNull()) { fmind = as<double>(filterMind); }
+
+  // one block holds at most memLimit MB of genotype, and columns are
+  // visited in file order so that every pass is a sequential scan
+  size_t blockCols = bigmat_block_cols(pMat, memLimit, sizeof(T));
+
+  if (verbose) {
+    Rcout << " Options in effect:" << endl;
+    if (keepInds.isNotNull()  ) { Rcout << "   --keep-ind filePed "       << endl; }
+    if (filterGeno.isNotNull()) { Rcout << "   --geno " << fgeno  << endl; }
+    if (filterHWE.isNotNull() ) { Rcout << "   --hwe "  << fhwe   << endl; }
+    if (filterMAF.isNotNull() ) { Rcout << "   --maf "  << fmaf   << endl; }
+    if (filterMind.isNotNull()) { Rcout << "   --mind " << fmind  << endl; }
+    Rcout << "   --memory " << memLimit << " MB (" << blockCols << " samples per block)" << endl;
+    Rcout << endl;
+    Rcout << " Detect " << n << " samples and " << m << " variants" << endl;
+    Rcout << endl;
+  }
+
+  bigmat_advise<T>(pMat, 0, nAll, BM_SEQUENTIAL);
+
+  if (filterMind.isNotNull()) {
+    if (verbose) { Rcout << " Calculating sample missingness rates..."; }
+    vector<size_t> cols(keepCols.begin(), keepCols.end());
+    std::sort(cols.begin(), cols.end());
+    vector<double> colNumNA(nAll, 0);
+    vector<double> blockNA(blockCols);
+    for (b = 0; b < cols.size(); b += blockCols) {
+      size_t nb = min(blockCols, cols.size() - b);
+      if (b + nb < cols.size()) {
+        bigmat_advise<T>(pMat, cols[b + nb], cols[min(b + 2 * nb, cols.size()) - 1] + 1, BM_WILLNEED);
+      }
+      #pragma omp parallel for schedule(dynamic) private(i, k)
+      for (k = 0; k < nb; k++) {
+        double s = 0;
+        T *col = bigm[cols[b + k]];
+        for (i = 0; i < m; i++) {
+          if (col[i] == NA_C) { s += 1; }
+        }
+        blockNA[k] = s;
+      }
+      for (k = 0; k < nb; k++) { colNumNA[cols[b + k]] = blockNA[k]; }
+      bigmat_advise<T>(pMat, cols[b], cols[b + nb - 1] + 1, BM_DONTNEED);
+    }
+    if (verbose) {  Rcout << " done." << endl; }
+    LogicalVector keepFlag(keepCols.size());
+    for (j = 0; j < (size_t)keepCols.size(); j++) {
+      keepFlag[j] = colNumNA[keepCols[j]] / m < fmind;
+    }
+    keepCols = keepCols[keepFlag];
+    if (verbose) {
+      Rcout << " " << (n - keepCols.size())  << " samples removed due to missing genotype data (--mind)." << endl;
+      Rcout << " " << keepCols.size() << " samples remaining after main filters." << endl;
+      Rcout << endl;
+    }
+    n = keepCols.size();
+  }
+
+  // per variant counts of 0, 1, 2 and missing genotypes, the only state
+  // kept across blocks
+  vector<int> cnt0, cnt1, cnt2, cntNA;
+  if (filterGeno.isNotNull() || filterMAF.isNotNull() || filterHWE.isNotNull()) {
+    if (verbose) { Rcout << " Calculating Genotype Frequencies..."; }
+    cnt0.assign(m, 0); cnt1.assign(m, 0); cnt2.assign(m, 0); cntNA.assign(m, 0);
+    vector<size_t> cols(keepCols.begin(), keepCols.end());
+    std::sort(cols.begin(), cols.end());
+    for (b = 0; b < cols.size(); b += blockCols) {
+      size_t nb = min(blockCols, cols.size() - b);
+      if (b + nb < cols.size()) {
+        bigmat_advise<T>(pMat, cols[b + nb], cols[min(b + 2 * nb, cols.size()) - 1] + 1, BM_WILLNEED);
+      }
+      // threads own disjoint variant ranges, so the counters need no reduction
+      #pragma omp parallel for schedule(static) private(i, k)
+      for (i = 0; i < m; i++) {
+        for (k = 0; k < nb; k++) {
+          T g = bigm[cols[b + k]][i];
+          if (g == 0) {
+            cnt0[i]++;
+          } else if (g == 1) {
+            cnt1[i]++;
+          } else if (g == 2) {
+            cnt2[i]++;
+          } else if (g == NA_C) {
+            cntNA[i]++;
+          }
+        }
+      }
+      bigmat_advise<T>(pMat, cols[b], cols[b + nb - 1] + 1, BM_DONTNEED);
+    }
+    if (verbose) {  Rcout << " done." << endl << endl; }
+  }
+  bigmat_advise<T>(pMat, 0, nAll, BM_NORMAL);
+
+  vector<int> rows(m);
+  for (i = 0; i < m; i++) { rows[i] = i; }
+
+  if (filterGeno.isNotNull()) {
+    vector<int> keep;
+    for (i = 0; i < rows.size(); i++) {
+      if (cntNA[rows[i]] / n < fgeno) { keep.push_back(rows[i]); }
+    }
+    if (verbose) {
+      Rcout << " " << (rows.size() - keep.size()) << " variants removed due to missing genotype data (--geno)." << endl;
+      Rcout << " " << keep.size() << " variants remaining after main filters." << endl;
+      Rcout << endl;
+    }
+    rows.swap(keep);
+  }
+
+  if (filterHWE.isNotNull()) {
+    if (verbose) { Rcout << " Performing Hardy-Weinberg test..."; }
+    vector<double> PVAL(rows.size());
+    #pragma omp parallel for schedule(dynamic) private(i)
+    for (i = 0; i < rows.size(); i++) {
+      PVAL[i] = SNPHWE(cnt1[rows[i]], cnt0[rows[i]], cnt2[rows[i]]);
+    }
+    if (verbose) {  Rcout << " done." << endl; }
+    vector<int> keep;
+    for (i = 0; i < rows.size(); i++) {
+      if (PVAL[i] > fhwe) { keep.push_back(rows[i]); }
+    }
+    if (verbose) {
+      Rcout << " " << (rows.size() - keep.size()) << " variants removed due to exceeding HWE-P-Value (--hwe)." << endl;
+      Rcout << " " << keep.size() << " variants remaining after main filters." << endl;
+      Rcout << endl;
+    }
+    rows.swap(keep);
+  }
+
+  if (filterMAF.isNotNull()) {
+    if (verbose) { Rcout << " Calculating Minor Allele Frequencies..."; }
+    vector<int> keep;
+    for (i = 0; i < rows.size(); i++) {
+      double maf = (cnt0[rows[i]] + cnt1[rows[i]] * 0.5) / (cnt0[rows[i]] + cnt1[rows[i]] + cnt2[rows[i]]);
+      maf = maf <= 0.5 ? maf : (1 - maf);
+      if (maf >= fmaf) { keep.push_back(rows[i]); }
+    }
+    if (verbose) {  Rcout << " done." << endl; }
+    if (verbose) {
+      Rcout << " " << (rows.size() - keep.size()) << " variants removed due to exceeding MAF (--maf)." << endl;
+      Rcout << " " << keep.size() << " variants remaining after main filters." << endl;
+      Rcout << endl;
+    }
+    rows.swap(keep);
+  }
+
+  IntegerVector keepRows = wrap(rows);
+  keepRows = keepRows + 1;
+  keepCols = keepCols + 1;
+  List genoInfo = List::create(Named("keepRows") = keepRows,
+                                   _["keepCols"] = keepCols);
+  return genoInfo;
+}
+
+// [[Rcpp::export]]
+List GenoFilterChunk(const SEXP pBigMat, Nullable<IntegerVector> keepInds=R_NilValue, Nullable<double> filterGeno=R_NilValue, Nullable<double> filterHWE=R_NilValue, Nullable<double> filterMind=R_NilValue, Nullable<double> filterMAF=R_NilValue, double memLimit=256, int threads=0, bool verbose=true) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+
+  switch(xpMat->matrix_type()) {
+  case 1:
+    return GenoFilterChunk<char>(xpMat, NA_CHAR, keepInds, filterGeno, filterHWE, filterMind, filterMAF, memLimit, threads, verbose);
+  case 2:
+    return GenoFilterChunk<short>(xpMat, NA_SHORT, keepInds, filterGeno, filterHWE, filterMind, filterMAF, memLimit, threads, verbose);
+  case 4:
+    return GenoFilterChunk<int>(xpMat, NA_INTEGER, keepInds, filterGeno, filterHWE, filterMind, filterMAF, memLimit, threads, verbose);
+  case 8:
+    return GenoFilterChunk<double>(xpMat, NA_REAL, keepInds, filterGeno, filterHWE, filterMind, filterMAF, memLimit, threads, verbose);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
+
+template<typename T, typename S>
+void BigMatSubset(XPtr<BigMatrix> pMat, XPtr<BigMatrix> pmat, double NA_T, double NA_S, IntegerVector rowIdx, IntegerVector colIdx, double memLimit=256, int threads=0, bool verbose=true) {
+  omp_setup(threads);
+
+  MatrixAccessor<T> bigmat = MatrixAccessor<T>(*pMat);
+  MatrixAccessor<S> bigm = MatrixAccessor<S>(*pmat);
+
+  size_t i, j, b, m = rowIdx.size(), n = colIdx.size();
+  if (m != pMat->nrow() || n != pMat->ncol()) {
+    Rcpp::stop("'bigmat' should have the same size as 'rowIdx' and 'colIdx'!");
+  }
+  if (m == 0 || n == 0) { return; }
+  if (min(rowIdx) < 1 || max(rowIdx) > pmat->nrow()) {
+    Rcpp::stop("'rowIdx' is out of bound!");
+  }
+  if (min(colIdx) < 1 || max(colIdx) > pmat->ncol()) {
+    Rcpp::stop("'colIdx' is out of bound!");
+  }
+  vector<size_t> ri(m), ci(n);
+  for (i = 0; i < m; i++) { ri[i] = rowIdx[i] - 1; }
+  for (j = 0; j < n; j++) { ci[j] = colIdx[j] - 1; }
+
+  size_t blockCols = bigmat_block_cols(pmat, memLimit, sizeof(S));
+
+  MinimalProgressBar pb;
+  Progress p((n + blockCols - 1) / blockCols, verbose, pb);
+
+  for (b = 0; b < n; b += blockCols) {
+    size_t nb = min(blockCols, n - b);
+    for (j = b + nb; j < min(b + 2 * nb, n); j++) {
+      bigmat_advise<S>(pmat, ci[j], ci[j] + 1, BM_WILLNEED);
+    }
+    #pragma omp parallel for schedule(static) private(i, j)
+    for (j = b; j < b + nb; j++) {
+      S *src = bigm[ci[j]];
+      T *dst = bigmat[j];
+      for (i = 0; i < m; i++) {
+        S g = src[ri[i]];
+        dst[i] = (g == NA_S) ? static_cast<T>(NA_T) : static_cast<T>(g);
+      }
+    }
+    for (j = b; j < b + nb; j++) {
+      bigmat_advise<S>(pmat, ci[j], ci[j] + 1, BM_DONTNEED);
+    }
+    if ( ! Progress::check_abort() ) { p.increment(); }
+  }
+}
+
+template<typename T>
+void BigMatSubset(XPtr<BigMatrix> pMat, XPtr<BigMatrix> pmat, double NA_T, IntegerVector rowIdx, IntegerVector colIdx, double memLimit=256, int threads=0, bool verbose=true) {
+  switch(pmat->matrix_type()) {
+  case 1:
+    return BigMatSubset<T, char>(pMat, pmat, NA_T, NA_CHAR, rowIdx, colIdx, memLimit, threads, verbose);
+  case 2:
+    return BigMatSubset<T, short>(pMat, pmat, NA_T, NA_SHORT, rowIdx, colIdx, memLimit, threads, verbose);
+  case 4:
+    return BigMatSubset<T, int>(pMat, pmat, NA_T, NA_INTEGER, rowIdx, colIdx, memLimit, threads, verbose);
+  case 8:
+    return BigMatSubset<T, double>(pMat, pmat, NA_T, NA_REAL, rowIdx, colIdx, memLimit, threads, verbose);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
+
+// [[Rcpp::export]]
+void BigMatSubset(const SEXP pBigMat, const SEXP pBigmat, IntegerVector rowIdx, IntegerVector colIdx, double memLimit=256, int threads=0, bool verbose=true) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+  XPtr<BigMatrix> xpmat(pBigmat);
+
+  switch(xpMat->matrix_type()) {
+  case 1:
+    return BigMatSubset<char>(xpMat, xpmat, NA_CHAR, rowIdx, colIdx, memLimit, threads, verbose);
+  case 2:
+    return BigMatSubset<short>(xpMat, xpmat, NA_SHORT, rowIdx, colIdx, memLimit, threads, verbose);
+  case 4:
+    return BigMatSubset<int>(xpMat, xpmat, NA_INTEGER, rowIdx, colIdx, memLimit, threads, verbose);
+  case 8:
+    return BigMatSubset<double>(xpMat, xpmat, NA_REAL, rowIdx, colIdx, memLimit, threads, verbose);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
+
 template<typename T>
 void Mat2BigMat(XPtr<BigMatrix> pMat, IntegerMatrix mat, Nullable<IntegerVector> colIdx=R_NilValue, int op=1, int threads=0) {
   omp_setup(threads);
@@ -554,3 +835,268 @@ void GenoMixer(const SEXP pBigMat, const SEXP pBigmat, IntegerVector sirIdx, Int
     throw Rcpp::exception("unknown type detected for big.matrix object!");
   }
 }
+
+template<typename T>
+List GenoStat(XPtr<BigMatrix> pMat, int incols=2, Nullable<IntegerVector> group=R_NilValue, int nBin=10, int threads=0) {
+  omp_setup(threads);
+  
+  MatrixAccessor<T> bigm = MatrixAccessor<T>(*pMat);
+  
+  size_t m = pMat->nrow(), ncol = pMat->ncol();
+  if (incols != 1 && incols != 2) {
+    Rcpp::stop("'incols' should only be 1 or 2!");
+  }
+  if (incols == 2 && ncol % 2 != 0) {
+    Rcpp::stop("the column number of genotype should be even when 'incols' is 2!");
+  }
+  if (nBin < 1) {
+    Rcpp::stop("'nBin' should be a positive integer!");
+  }
+  size_t n = ncol / incols;
+  
+  // sub-population of every individual, 0-based
+  vector<int> gi(n, 0);
+  int K = 1;
+  if (group.isNotNull()) {
+    IntegerVector grp = as<IntegerVector>(group);
+    if (grp.size() != n) {
+      Rcpp::stop("'group' should have the same length as individual number!");
+    }
+    for (size_t u = 0; u < n; u++) {
+      if (grp[u] == NA_INTEGER || grp[u] < 1) {
+        Rcpp::stop("'group' should be positive integers!");
+      }
+      gi[u] = grp[u] - 1;
+      if (grp[u] > K) { K = grp[u]; }
+    }
+  }
+  
+  NumericVector freq(m, NA_REAL);
+  vector<double> he(m, 0), ho(m, 0), hs(m, 0), ht(m, 0);
+  vector<unsigned char> obsd(m, 0);
+  
+  // rows are processed in blocks, every column contributes a contiguous
+  // piece of a block, and allele counts of each sub-population are kept
+  size_t bsize = 4096;
+  size_t nblock = (m + bsize - 1) / bsize;
+  
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t b = 0; b < nblock; b++) {
+    size_t r0 = b * bsize, r1 = min(m, r0 + bsize), len = r1 - r0;
+    vector<double> cnt(K * len, 0), obs(K * len, 0), het(len, 0), nind(len, 0);
+    for (size_t u = 0; u < n; u++) {
+      size_t g = gi[u] * len;
+      if (incols == 2) {
+        T *c1 = bigm[2 * u], *c2 = bigm[2 * u + 1];
+        for (size_t i = r0; i < r1; i++) {
+          T x1 = c1[i], x2 = c2[i];
+          if ((x1 == 0 || x1 == 1) && (x2 == 0 || x2 == 1)) {
+            cnt[g + i - r0] += x1 + x2;
+            obs[g + i - r0] += 2;
+            het[i - r0] += (x1 != x2);
+            nind[i - r0] += 1;
+          }
+        }
+      } else {
+        T *c1 = bigm[u];
+        for (size_t i = r0; i < r1; i++) {
+          T x = c1[i];
+          if (x == 0 || x == 1 || x == 2) {
+            cnt[g + i - r0] += x;
+            obs[g + i - r0] += 2;
+            het[i - r0] += (x == 1);
+            nind[i - r0] += 1;
+          }
+        }
+      }
+    }
+    
+    for (size_t i = 0; i < len; i++) {
+      double c = 0, o = 0, s = 0;
+      for (int k = 0; k < K; k++) {
+        double ck = cnt[k * len + i], ok = obs[k * len + i];
+        c += ck; o += ok;
+        if (ok > 0) { s += ok * 2 * (ck / ok) * (1 - ck / ok); }
+      }
+      if (o == 0) { continue; }
+      double p = c / o;
+      freq[r0 + i] = p;
+      obsd[r0 + i] = 1;
+      he[r0 + i] = 2 * p * (1 - p);
+      ho[r0 + i] = het[i] / nind[i];
+      hs[r0 + i] = s / o;
+      ht[r0 + i] = 2 * p * (1 - p);
+    }
+  }
+  
+  // genome-wide summary
+  double sumHe = 0, sumHo = 0, sumHS = 0, sumHT = 0, nobs = 0;
+  int fixed = 0, lost = 0;
+  IntegerVector sfs(nBin, 0);
+  for (size_t i = 0; i < m; i++) {
+    if (!obsd[i]) { continue; }
+    nobs += 1;
+    sumHe += he[i]; sumHo += ho[i];
+    sumHS += hs[i]; sumHT += ht[i];
+    double p = freq[i];
+    if (p == 1) {
+      fixed++;
+    } else if (p == 0) {
+      lost++;
+    } else {
+      int bin = static_cast<int>(p * nBin);
+      sfs[min(bin, nBin - 1)] += 1;
+    }
+  }
+  
+  double Fst = (K > 1 && sumHT > 0) ? (sumHT - sumHS) / sumHT : NA_REAL;
+  
+  return List::create(Named("freq") = freq,
+                      _["He"] = nobs > 0 ? sumHe / nobs : NA_REAL,
+                      _["Ho"] = nobs > 0 ? sumHo / nobs : NA_REAL,
+                      _["fixed"] = fixed,
+                      _["lost"] = lost,
+                      _["sfs"] = sfs,
+                      _["Fst"] = Fst);
+}
+
+// [[Rcpp::export]]
+List GenoStat(const SEXP pBigMat, int incols=2, Nullable<IntegerVector> group=R_NilValue, int nBin=10, int threads=0) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+  
+  switch(xpMat->matrix_type()) {
+  case 1:
+    return GenoStat<char>(xpMat, incols, group, nBin, threads);
+  case 2:
+    return GenoStat<short>(xpMat, incols, group, nBin, threads);
+  case 4:
+    return GenoStat<int>(xpMat, incols, group, nBin, threads);
+  case 8:
+    return GenoStat<double>(xpMat, incols, group, nBin, threads);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
+
+// Gene drop through a whole pedigree: every offspring takes haplotype
+// 'hapSir' (0 or 1) of its sire and 'hapDam' of its dam, the offspring of
+// 'swapInd' exchange their two haplotypes on 'recomRows', and the alleles
+// ('mutRow', 'mutCol') of the offspring haplotypes mutate. Parents are coded
+// 1-based over the individuals of 'pFounder' and then the offspring of
+// 'pMat', so that the offspring are written straight into their columns of
+// 'pMat' layer by layer, every layer 'layer' being dropped in parallel.
+template<typename T>
+void GeneDrop(XPtr<BigMatrix> pMat, XPtr<BigMatrix> pFounder, IntegerVector sir, IntegerVector dam, IntegerVector layer, IntegerVector hapSir, IntegerVector hapDam, IntegerVector swapInd, IntegerVector recomRows, IntegerVector mutRow, IntegerVector mutCol, int threads=0) {
+  omp_setup(threads);
+
+  MatrixAccessor<T> bigmat = MatrixAccessor<T>(*pMat);
+  MatrixAccessor<T> bigf = MatrixAccessor<T>(*pFounder);
+
+  size_t m = pMat->nrow(), n = sir.length();
+  size_t nf = pFounder->ncol() / 2;
+  if (m != (size_t)pFounder->nrow()) {
+    Rcpp::stop("'bigmat' and 'founder' should have the same marker number!");
+  }
+  if (2 * n != (size_t)pMat->ncol()) {
+    Rcpp::stop("'bigmat' should have two columns for every offspring!");
+  }
+  if ((size_t)dam.length() != n || (size_t)layer.length() != n || (size_t)hapSir.length() != n || (size_t)hapDam.length() != n) {
+    Rcpp::stop("'sir', 'dam', 'layer', 'hapSir' and 'hapDam' should have the same length!");
+  }
+  if (mutRow.length() != mutCol.length()) {
+    Rcpp::stop("'mutRow' and 'mutCol' should have the same length!");
+  }
+  for (size_t j = 0; j < n; j++) {
+    int p[2] = {sir[j], dam[j]};
+    for (int k = 0; k < 2; k++) {
+      if (p[k] < 1 || (size_t)p[k] > nf + j) {
+        Rcpp::stop("parents should be known and precede their offspring!");
+      }
+      if ((size_t)p[k] > nf && layer[p[k] - nf - 1] >= layer[j]) {
+        Rcpp::stop("parents should be in earlier layers than their offspring!");
+      }
+    }
+    if (j > 0 && layer[j] < layer[j - 1]) {
+      Rcpp::stop("offspring should be ordered by layer!");
+    }
+  }
+
+  vector<char> swap(n, 0);
+  for (int k = 0; k < swapInd.length(); k++) {
+    if (swapInd[k] < 1 || (size_t)swapInd[k] > n) {
+      Rcpp::stop("'swapInd' is out of bound!");
+    }
+    swap[swapInd[k] - 1] = 1;
+  }
+  vector<size_t> recom;
+  for (int k = 0; k < recomRows.length(); k++) {
+    if (recomRows[k] < 1 || (size_t)recomRows[k] > m) {
+      Rcpp::stop("'recomRows' is out of bound!");
+    }
+    recom.push_back(recomRows[k] - 1);
+  }
+
+  // mutations grouped by the offspring they hit
+  vector<size_t> mutStart(n + 1, 0), mutIdx(mutRow.length());
+  for (int k = 0; k < mutRow.length(); k++) {
+    if (mutRow[k] < 1 || (size_t)mutRow[k] > m || mutCol[k] < 1 || (size_t)mutCol[k] > 2 * n) {
+      Rcpp::stop("'mutRow' or 'mutCol' is out of bound!");
+    }
+    mutStart[(mutCol[k] - 1) / 2 + 1]++;
+  }
+  for (size_t j = 0; j < n; j++) { mutStart[j + 1] += mutStart[j]; }
+  vector<size_t> fill(mutStart.begin(), mutStart.end() - 1);
+  for (int k = 0; k < mutRow.length(); k++) {
+    mutIdx[fill[(mutCol[k] - 1) / 2]++] = k;
+  }
+
+  size_t lo = 0;
+  while (lo < n) {
+    size_t hi = lo;
+    while (hi < n && layer[hi] == layer[lo]) { hi++; }
+
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t j = lo; j < hi; j++) {
+      int p[2] = {sir[j] - 1, dam[j] - 1};
+      int h[2] = {hapSir[j], hapDam[j]};
+      for (int k = 0; k < 2; k++) {
+        T *from = (size_t)p[k] < nf ? bigf[2 * p[k] + h[k]] : bigmat[2 * (p[k] - nf) + h[k]];
+        T *to = bigmat[2 * j + k];
+        for (size_t i = 0; i < m; i++) { to[i] = from[i]; }
+      }
+      if (swap[j]) {
+        T *h1 = bigmat[2 * j], *h2 = bigmat[2 * j + 1];
+        for (size_t r = 0; r < recom.size(); r++) { std::swap(h1[recom[r]], h2[recom[r]]); }
+      }
+      // mutations in order, as the same allele can be hit twice
+      for (size_t k = mutStart[j]; k < mutStart[j + 1]; k++) {
+        size_t u = mutIdx[k];
+        T &a = bigmat[mutCol[u] - 1][mutRow[u] - 1];
+        a = a == 1 ? 0 : 1;
+      }
+    }
+    lo = hi;
+  }
+}
+
+// [[Rcpp::export]]
+void GeneDrop(const SEXP pBigMat, const SEXP pFounder, IntegerVector sir, IntegerVector dam, IntegerVector layer, IntegerVector hapSir, IntegerVector hapDam, IntegerVector swapInd, IntegerVector recomRows, IntegerVector mutRow, IntegerVector mutCol, int threads=0) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+  XPtr<BigMatrix> xpFounder(pFounder);
+  if (xpMat->matrix_type() != xpFounder->matrix_type()) {
+    Rcpp::stop("'bigmat' and 'founder' should have the same type!");
+  }
+
+  switch(xpMat->matrix_type()) {
+  case 1:
+    return GeneDrop<char>(xpMat, xpFounder, sir, dam, layer, hapSir, hapDam, swapInd, recomRows, mutRow, mutCol, threads);
+  case 2:
+    return GeneDrop<short>(xpMat, xpFounder, sir, dam, layer, hapSir, hapDam, swapInd, recomRows, mutRow, mutCol, threads);
+  case 4:
+    return GeneDrop<int>(xpMat, xpFounder, sir, dam, layer, hapSir, hapDam, swapInd, recomRows, mutRow, mutCol, threads);
+  case 8:
+    return GeneDrop<double>(xpMat, xpFounder, sir, dam, layer, hapSir, hapDam, swapInd, recomRows, mutRow, mutCol, threads);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
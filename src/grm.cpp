@@ -0,0 +1,350 @@
+#include "kinship.h"
+#include "MinimalProgressBar.h"
+
+// [[Rcpp::plugins(cpp11)]]
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::depends(bigmemory, BH)]]
+using namespace std;
+using namespace Rcpp;
+
+// Genomic relationship as a linear operator, G x being computed without
+// forming G:
+//   genotype: G x = Z (Z'x) / denom, Z being streamed in marker blocks from
+//             the big.matrix, so that only O(nm) genotype and O(n r) vectors
+//             are needed. The diagonal of Yang is corrected afterwards;
+//   packed  : G is read from a packed kinship file (see packed.h).
+struct GrmOperator {
+  bool packed;
+  size_t n, m, nb, incols;
+  KinMethod kin;
+  double denom;
+  vector<double> freq, dcorr;
+  RObject geno;          // keeps the big.matrix alive
+  BigMatrix *pMat;
+  PackedSym pk;
+
+  GrmOperator() : packed(false), n(0), m(0), nb(0), incols(1), kin(KIN_VANRADEN), denom(1), pMat(NULL) {}
+};
+
+template <typename T>
+static vector<T*> grm_op_cols(BigMatrix *pMat) {
+  MatrixAccessor<T> bigm = MatrixAccessor<T>(*pMat);
+  vector<T*> cols(pMat->ncol());
+  for (size_t j = 0; j < cols.size(); j++) { cols[j] = bigm[j]; }
+  return cols;
+}
+
+// diagonal of Yang minus the diagonal of ZZ' / denom, one pass over markers
+template <typename T>
+static void grm_op_dcorr(GrmOperator &op) {
+  vector<T*> cols = grm_op_cols<T>(op.pMat);
+  vector<double> Z, diag(op.n, 0), zz(op.n, 0);
+  for (size_t k0 = 0; k0 < op.m; k0 += op.nb) {
+    size_t k1 = min(op.m, k0 + op.nb), nbk = k1 - k0;
+    kin_block<T>(cols, k0, k1, op.kin, op.freq, Z, &diag);
+    #pragma omp parallel for schedule(static)
+    for (size_t j = 0; j < op.n; j++) {
+      const double *z = &Z[j * nbk];
+      double s = 0;
+      for (size_t k = 0; k < nbk; k++) { s += z[k] * z[k]; }
+      zz[j] += s;
+    }
+  }
+  op.dcorr.resize(op.n);
+  for (size_t j = 0; j < op.n; j++) { op.dcorr[j] = (1 + diag[j] / op.denom) - zz[j] / op.denom; }
+}
+
+// Y = G X for a batch of r right-hand sides, both n x r column-major, the
+// genotype being the columns 'cols'
+template <typename T>
+static void grm_op_mult(const GrmOperator &op, const vector<T*> &cols, const double *X, size_t r, double *Y) {
+  size_t n = op.n;
+  vector<double> Z, W;
+  std::fill(Y, Y + n * r, 0.0);
+  for (size_t k0 = 0; k0 < op.m; k0 += op.nb) {
+    size_t k1 = min(op.m, k0 + op.nb), nbk = k1 - k0;
+    kin_block<T>(cols, k0, k1, op.kin, op.freq, Z, NULL, op.incols);
+    W.resize(nbk * r);
+    // W = Z_b X, Y += Z_b' W
+    blas_gemm("N", "N", nbk, r, n, Z.data(), nbk, X, n, 0.0, W.data(), nbk);
+    blas_gemm("T", "N", n, r, nbk, Z.data(), nbk, W.data(), nbk, 1.0, Y, n);
+  }
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; i++) {
+    for (size_t c = 0; c < r; c++) {
+      Y[c * n + i] /= op.denom;
+      if (!op.dcorr.empty()) { Y[c * n + i] += op.dcorr[i] * X[c * n + i]; }
+    }
+  }
+}
+
+// Y = G X on the packed upper triangle, every column j adding to the rows
+// i <= j and to the row j; threads accumulate into their own Y.
+static void grm_op_mult_packed(const GrmOperator &op, const double *X, size_t r, double *Y) {
+  size_t n = op.n;
+  std::fill(Y, Y + n * r, 0.0);
+
+  #pragma omp parallel
+  {
+    vector<double> acc(n * r, 0);
+    #pragma omp for schedule(dynamic, 64)
+    for (size_t j = 0; j < n; j++) {
+      const float *col = op.pk.data + PackedSym::index(0, j);
+      for (size_t c = 0; c < r; c++) {
+        const double *x = X + c * n;
+        double *a = &acc[c * n];
+        double xj = x[j], s = 0;
+        for (size_t i = 0; i < j; i++) {
+          a[i] += col[i] * xj;
+          s += col[i] * x[i];
+        }
+        a[j] += s + col[j] * xj;
+      }
+    }
+    #pragma omp critical
+    {
+      for (size_t k = 0; k < n * r; k++) { Y[k] += acc[k]; }
+    }
+  }
+}
+
+// Operator on the genotype of a big.matrix (markers x individuals), 'ref'
+// being the allele frequencies (see KinshipRef).
+// [[Rcpp::export]]
+SEXP GrmOperatorCreate(SEXP pBigMat, NumericVector ref, std::string method="VanRaden", double memLimit=256, int threads=0) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+  omp_setup(threads);
+
+  KinMethod kin = kin_method(method);
+  if (kin == KIN_EMMA) {
+    Rcpp::stop("'method' should be 'VanRaden' or 'Yang'!");
+  }
+  if (ref.size() != xpMat->nrow()) {
+    Rcpp::stop("'ref' should have the same length as marker number!");
+  }
+
+  GrmOperator *op = new GrmOperator();
+  XPtr<GrmOperator> ptr(op, true);
+  op->geno = pBigMat;
+  op->pMat = xpMat.get();
+  op->n = xpMat->ncol();
+  op->m = xpMat->nrow();
+  op->nb = kin_block_rows(op->m, op->n, memLimit);
+  op->kin = kin;
+  op->freq.assign(ref.begin(), ref.end());
+  op->denom = kin_scale(op->freq, kin);
+  if (op->denom <= 0) {
+    Rcpp::stop("all markers are monomorphic!");
+  }
+
+  if (kin == KIN_YANG) {
+    switch(xpMat->matrix_type()) {
+    case 1:
+      grm_op_dcorr<char>(*op); break;
+    case 2:
+      grm_op_dcorr<short>(*op); break;
+    case 4:
+      grm_op_dcorr<int>(*op); break;
+    case 8:
+      grm_op_dcorr<double>(*op); break;
+    default:
+      throw Rcpp::exception("unknown type detected for big.matrix object!");
+    }
+  }
+  return ptr;
+}
+
+// Operator on a packed kinship file, memory-mapped
+// [[Rcpp::export]]
+SEXP GrmOperatorPacked(std::string kin_file) {
+  GrmOperator *op = new GrmOperator();
+  XPtr<GrmOperator> ptr(op, true);
+  op->packed = true;
+  op->pk.open(kin_file);
+  op->n = op->pk.n;
+  return ptr;
+}
+
+// [[Rcpp::export]]
+double GrmOperatorDim(SEXP pOp) {
+  XPtr<GrmOperator> op(pOp);
+  return op->n;
+}
+
+// G X for a n x r matrix X
+// [[Rcpp::export]]
+NumericMatrix GrmOperatorMult(SEXP pOp, NumericMatrix X, int threads=0) {
+  XPtr<GrmOperator> op(pOp);
+  omp_setup(threads);
+
+  if ((size_t)X.nrow() != op->n) {
+    Rcpp::stop("the row number of 'x' should be the individual number of the operator!");
+  }
+  size_t r = X.ncol();
+  NumericMatrix Y(op->n, r);
+  if (op->packed) {
+    grm_op_mult_packed(*op, X.begin(), r, Y.begin());
+    return Y;
+  }
+
+  switch(op->pMat->matrix_type()) {
+  case 1:
+    grm_op_mult<char>(*op, grm_op_cols<char>(op->pMat), X.begin(), r, Y.begin()); break;
+  case 2:
+    grm_op_mult<short>(*op, grm_op_cols<short>(op->pMat), X.begin(), r, Y.begin()); break;
+  case 4:
+    grm_op_mult<int>(*op, grm_op_cols<int>(op->pMat), X.begin(), r, Y.begin()); break;
+  case 8:
+    grm_op_mult<double>(*op, grm_op_cols<double>(op->pMat), X.begin(), r, Y.begin()); break;
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+  return Y;
+}
+
+// marker loadings L = Z U, m x k, one pass over markers
+template <typename T>
+static void grm_op_loadings(const GrmOperator &op, const vector<T*> &cols, const arma::mat &U, arma::mat &L) {
+  size_t k = U.n_cols;
+  vector<double> Z;
+  L.set_size(op.m, k);
+  for (size_t k0 = 0; k0 < op.m; k0 += op.nb) {
+    size_t k1 = min(op.m, k0 + op.nb), nbk = k1 - k0;
+    kin_block<T>(cols, k0, k1, op.kin, op.freq, Z, NULL, op.incols);
+    blas_gemm("N", "N", nbk, k, op.n, Z.data(), nbk, U.memptr(), op.n, 0.0, L.memptr() + k0, op.m);
+  }
+}
+
+// Top k principal components of the standardized genotype by randomized
+// block Krylov iteration (Musco and Musco, 2015). The Krylov basis
+// [GW, G^2 W, ..., G^q W] of a random n x l start W takes q passes over
+// the markers, the Rayleigh-Ritz step on it one more and the loadings a
+// last one, so that memory is O((n + m) q l) and G is never formed.
+template <typename T>
+static List grm_pca(GrmOperator &op, const vector<T*> &cols, int k, int iter, int oversample, bool verbose) {
+  size_t n = op.n, l = k + oversample;
+
+  MinimalProgressBar pb;
+  Progress p(iter + 2, verbose, pb);
+
+  NumericVector w = Rcpp::rnorm(n * l);
+  arma::mat W(w.begin(), n, l), GW(n, l), Qb, Rb;
+  arma::mat basis(n, iter * l);
+  for (int i = 0; i < iter; i++) {
+    grm_op_mult<T>(op, cols, W.memptr(), l, GW.memptr());
+    arma::qr_econ(Qb, Rb, GW);
+    W = Qb;
+    basis.cols(i * l, (i + 1) * l - 1) = Qb;
+    if ( ! Progress::check_abort() ) { p.increment(); }
+  }
+
+  // Rayleigh-Ritz on the orthonormal basis Q: eigen of Q'GQ
+  arma::mat Q, R;
+  arma::qr_econ(Q, R, basis);
+  basis.reset();
+  arma::mat GQ(n, Q.n_cols);
+  grm_op_mult<T>(op, cols, Q.memptr(), Q.n_cols, GQ.memptr());
+  arma::mat S = Q.t() * GQ;
+  S = (S + S.t()) / 2;
+  GQ.reset();
+  if ( ! Progress::check_abort() ) { p.increment(); }
+
+  arma::vec lambda;
+  arma::mat V;
+  arma::eig_sym(lambda, V, S);
+  arma::uvec top = arma::sort_index(lambda, "descend");
+  top = top.head(k);
+  arma::vec values = arma::clamp(lambda.elem(top), 0.0, arma::datum::inf);
+  arma::mat U = Q * V.cols(top);
+
+  // Z' = U S L', the singular values S being sqrt(denom * values)
+  arma::vec sigma = arma::sqrt(values * op.denom);
+  arma::mat L;
+  grm_op_loadings<T>(op, cols, U, L);
+  for (int c = 0; c < k; c++) {
+    if (sigma[c] > 0) { L.col(c) /= sigma[c]; }
+  }
+  if ( ! Progress::check_abort() ) { p.increment(); }
+
+  arma::mat pcs = U.each_row() % sigma.t();
+  return List::create(_["values"] = NumericVector(values.begin(), values.end()),
+                      _["vectors"] = U, _["pcs"] = pcs, _["loadings"] = L);
+}
+
+// PCA of the individuals of one or more big.matrix objects of the same
+// type and markers, 'incols' columns making an individual
+template <typename T>
+static List grm_pca(List pBigMats, std::string method, int incols, int k, int iter, int oversample, double memLimit, bool verbose) {
+  GrmOperator op;
+  op.kin = kin_method(method);
+  op.incols = incols;
+
+  vector<T*> cols;
+  vector<double> cnt;
+  for (int g = 0; g < pBigMats.size(); g++) {
+    XPtr<BigMatrix> xpMat(pBigMats[g]);
+    MatrixAccessor<T> bigm = MatrixAccessor<T>(*xpMat);
+    size_t m = xpMat->nrow(), ng = xpMat->ncol() / incols;
+    if (g == 0) {
+      op.m = m;
+      op.freq.assign(m, 0);
+      cnt.assign(m, 0);
+    } else if (m != op.m) {
+      Rcpp::stop("all genotype matrices should have the same markers!");
+    }
+    for (size_t j = 0; j < ng * incols; j++) { cols.push_back(bigm[j]); }
+
+    // frequency over all matrices, weighted by their individuals
+    vector<double> freq = kin_freq<T>(bigm, m, ng, incols);
+    for (size_t i = 0; i < m; i++) { op.freq[i] += freq[i] * ng; cnt[i] += ng; }
+    op.n += ng;
+  }
+  for (size_t i = 0; i < op.m; i++) { op.freq[i] /= cnt[i]; }
+  op.denom = kin_scale(op.freq, op.kin);
+  if (op.denom <= 0) {
+    Rcpp::stop("all markers are monomorphic!");
+  }
+  if (k < 1 || (size_t)k > op.n) {
+    Rcpp::stop("'k' should be positive and not more than the individual number!");
+  }
+  // the Krylov basis has at most n columns, so that the oversampling and
+  // the iterations are cut down for small populations
+  oversample = max(0, min(oversample, (int)op.n - k));
+  iter = max(1, min(iter, (int)(op.n / (k + oversample))));
+  op.nb = kin_block_rows(op.m, op.n, memLimit);
+
+  return grm_pca<T>(op, cols, k, iter, oversample, verbose);
+}
+
+// [[Rcpp::export]]
+List GrmPCA(List pBigMats, std::string method="VanRaden", int incols=1, int k=10, int iter=4, int oversample=10, double memLimit=256, int threads=0, bool verbose=true) {
+  omp_setup(threads);
+
+  if (kin_method(method) == KIN_EMMA) {
+    Rcpp::stop("'method' should be 'VanRaden' or 'Yang'!");
+  }
+  if (pBigMats.size() == 0) {
+    Rcpp::stop("no genotype matrix!");
+  }
+  XPtr<BigMatrix> xpMat(pBigMats[0]);
+  int type = xpMat->matrix_type();
+  for (int g = 1; g < pBigMats.size(); g++) {
+    XPtr<BigMatrix> xp(pBigMats[g]);
+    if (xp->matrix_type() != type) {
+      Rcpp::stop("all genotype matrices should be of the same type!");
+    }
+  }
+
+  switch(type) {
+  case 1:
+    return grm_pca<char>(pBigMats, method, incols, k, iter, oversample, memLimit, verbose);
+  case 2:
+    return grm_pca<short>(pBigMats, method, incols, k, iter, oversample, memLimit, verbose);
+  case 4:
+    return grm_pca<int>(pBigMats, method, incols, k, iter, oversample, memLimit, verbose);
+  case 8:
+    return grm_pca<double>(pBigMats, method, incols, k, iter, oversample, memLimit, verbose);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
@@ -0,0 +1,233 @@
+#include <Rcpp.h>
+#include "simer_omp.h"
+#include "MinimalProgressBar.h"
+
+// [[Rcpp::plugins(cpp11)]]
+using namespace std;
+using namespace Rcpp;
+
+// Founder-label track of identity by descent: every haplotype of the base
+// population gets its own label, and a haplotype is kept as runs of labels
+// along the markers, a run lasting until the start of the next one. Mating
+// copies haplotypes and the chromosome exchange of genotype() swaps the
+// runs of two haplotypes over some markers, so that only breakpoints are
+// stored instead of a label per marker.
+struct IbdRun {
+  int start;
+  int label;
+};
+
+struct IbdTrack {
+  size_t m;
+  vector< vector<IbdRun> > hap;
+};
+
+// haplotype taking the labels of 'b' on the marker ranges [r0, r1) and those
+// of 'a' elsewhere
+static vector<IbdRun> ibd_mix(const vector<IbdRun> &a, const vector<IbdRun> &b, const vector< pair<int, int> > &ranges, int m) {
+  vector<IbdRun> out;
+  size_t ia = 0, ib = 0, ir = 0;
+  int pos = 0;
+  while (pos < m) {
+    while (ia + 1 < a.size() && a[ia + 1].start <= pos) { ia++; }
+    while (ib + 1 < b.size() && b[ib + 1].start <= pos) { ib++; }
+    while (ir < ranges.size() && ranges[ir].second <= pos) { ir++; }
+    bool inB = ir < ranges.size() && ranges[ir].first <= pos;
+    int label = inB ? b[ib].label : a[ia].label;
+    if (out.empty() || out.back().label != label) {
+      IbdRun r = {pos, label};
+      out.push_back(r);
+    }
+
+    // next breakpoint of any of the three
+    int next = m;
+    if (ia + 1 < a.size()) { next = min(next, a[ia + 1].start); }
+    if (ib + 1 < b.size()) { next = min(next, b[ib + 1].start); }
+    if (ir < ranges.size()) { next = min(next, inB ? ranges[ir].second : ranges[ir].first); }
+    pos = next;
+  }
+  return out;
+}
+
+// number of markers on which two haplotypes share a label
+static int ibd_shared(const vector<IbdRun> &a, const vector<IbdRun> &b, int m) {
+  size_t ia = 0, ib = 0;
+  int pos = 0, shared = 0;
+  while (pos < m) {
+    int ea = ia + 1 < a.size() ? a[ia + 1].start : m;
+    int eb = ib + 1 < b.size() ? b[ib + 1].start : m;
+    int end = min(ea, eb);
+    if (a[ia].label == b[ib].label) { shared += end - pos; }
+    pos = end;
+    if (ea == end) { ia++; }
+    if (eb == end) { ib++; }
+  }
+  return shared;
+}
+
+// track of 'nhap' founder haplotypes of m markers, labelled from 'offset' + 1
+// [[Rcpp::export]]
+SEXP IbdFounder(double m, double nhap, double offset=0) {
+  IbdTrack *track = new IbdTrack();
+  XPtr<IbdTrack> ptr(track, true);
+  track->m = m;
+  track->hap.resize(nhap);
+  for (size_t h = 0; h < track->hap.size(); h++) {
+    IbdRun r = {0, (int)(offset + h + 1)};
+    track->hap[h].push_back(r);
+  }
+  return ptr;
+}
+
+// haplotypes 'colIdx' (1-based) of the tracks 'pIbds' put one after another,
+// as the genotype columns copied by mating
+// [[Rcpp::export]]
+SEXP IbdSubset(List pIbds, Nullable<IntegerVector> colIdx=R_NilValue) {
+  vector<const vector<IbdRun>*> haps;
+  size_t m = 0;
+  for (int t = 0; t < pIbds.size(); t++) {
+    XPtr<IbdTrack> src(as<SEXP>(pIbds[t]));
+    if (t == 0) {
+      m = src->m;
+    } else if (src->m != m) {
+      Rcpp::stop("all IBD tracks should have the same markers!");
+    }
+    for (size_t h = 0; h < src->hap.size(); h++) { haps.push_back(&src->hap[h]); }
+  }
+
+  IbdTrack *track = new IbdTrack();
+  XPtr<IbdTrack> ptr(track, true);
+  track->m = m;
+  if (colIdx.isNull()) {
+    track->hap.resize(haps.size());
+    for (size_t h = 0; h < haps.size(); h++) { track->hap[h] = *haps[h]; }
+  } else {
+    IntegerVector idx = as<IntegerVector>(colIdx);
+    track->hap.resize(idx.size());
+    for (int h = 0; h < idx.size(); h++) {
+      if (idx[h] < 1 || (size_t)idx[h] > haps.size()) {
+        Rcpp::stop("'colIdx' is out of bound!");
+      }
+      track->hap[h] = *haps[idx[h] - 1];
+    }
+  }
+  return ptr;
+}
+
+// Chromosome exchange in place: the two haplotypes of every individual of
+// 'inds' (1-based) swap their labels on the markers 'rows' (1-based).
+// [[Rcpp::export]]
+void IbdSwap(SEXP pIbd, IntegerVector rows, IntegerVector inds, int threads=0) {
+  XPtr<IbdTrack> track(pIbd);
+  omp_setup(threads);
+  int m = track->m;
+
+  // marker ranges [r0, r1) of the sorted rows
+  vector<int> r(rows.begin(), rows.end());
+  sort(r.begin(), r.end());
+  vector< pair<int, int> > ranges;
+  for (size_t k = 0; k < r.size(); k++) {
+    if (r[k] < 1 || r[k] > m) {
+      Rcpp::stop("'rows' is out of bound!");
+    }
+    int x = r[k] - 1;
+    if (!ranges.empty() && ranges.back().second >= x) {
+      ranges.back().second = max(ranges.back().second, x + 1);
+    } else {
+      ranges.push_back(make_pair(x, x + 1));
+    }
+  }
+  for (int u = 0; u < inds.size(); u++) {
+    if (inds[u] < 1 || 2 * (size_t)inds[u] > track->hap.size()) {
+      Rcpp::stop("'inds' is out of bound!");
+    }
+  }
+
+  #pragma omp parallel for schedule(dynamic)
+  for (int u = 0; u < inds.size(); u++) {
+    vector<IbdRun> &h1 = track->hap[2 * (inds[u] - 1)], &h2 = track->hap[2 * (inds[u] - 1) + 1];
+    vector<IbdRun> n1 = ibd_mix(h1, h2, ranges, m);
+    vector<IbdRun> n2 = ibd_mix(h2, h1, ranges, m);
+    h1.swap(n1);
+    h2.swap(n2);
+  }
+}
+
+// runs of every haplotype, 1-based
+// [[Rcpp::export]]
+DataFrame IbdSegments(SEXP pIbd) {
+  XPtr<IbdTrack> track(pIbd);
+  vector<int> hap, start, end, label;
+  for (size_t h = 0; h < track->hap.size(); h++) {
+    const vector<IbdRun> &runs = track->hap[h];
+    for (size_t k = 0; k < runs.size(); k++) {
+      hap.push_back(h + 1);
+      start.push_back(runs[k].start + 1);
+      end.push_back(k + 1 < runs.size() ? runs[k + 1].start : track->m);
+      label.push_back(runs[k].label);
+    }
+  }
+  return DataFrame::create(_["hap"] = hap, _["start"] = start, _["end"] = end, _["label"] = label);
+}
+
+// Realized relationship 2 * (coancestry) of the individuals 'inds'
+// (1-based, all if NULL) over the tracks 'pIbds' put one after another, the
+// coancestry being the average fraction of markers shared by the four
+// haplotype pairs; the diagonal is 1 + F, F being the fraction of markers
+// on which the two haplotypes of an individual share a label.
+// [[Rcpp::export]]
+List IbdKinship(List pIbds, Nullable<IntegerVector> inds=R_NilValue, int threads=0, bool verbose=true) {
+  omp_setup(threads);
+
+  vector<const vector<IbdRun>*> haps;
+  int m = 0;
+  for (int t = 0; t < pIbds.size(); t++) {
+    XPtr<IbdTrack> src(as<SEXP>(pIbds[t]));
+    if (t == 0) {
+      m = src->m;
+    } else if ((int)src->m != m) {
+      Rcpp::stop("all IBD tracks should have the same markers!");
+    }
+    for (size_t h = 0; h < src->hap.size(); h++) { haps.push_back(&src->hap[h]); }
+  }
+  if (haps.size() % 2 != 0) {
+    Rcpp::stop("the haplotype number should be even!");
+  }
+
+  vector<size_t> sel;
+  if (inds.isNull()) {
+    for (size_t u = 0; u < haps.size() / 2; u++) { sel.push_back(u); }
+  } else {
+    IntegerVector idx = as<IntegerVector>(inds);
+    for (int u = 0; u < idx.size(); u++) {
+      if (idx[u] < 1 || 2 * (size_t)idx[u] > haps.size()) {
+        Rcpp::stop("'inds' is out of bound!");
+      }
+      sel.push_back(idx[u] - 1);
+    }
+  }
+  size_t n = sel.size();
+
+  NumericMatrix kin(n, n);
+  NumericVector F(n);
+  double *K = kin.begin();
+  double *f = F.begin();
+
+  MinimalProgressBar pb;
+  Progress p(n, verbose, pb);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t j = 0; j < n; j++) {
+    const vector<IbdRun> &j1 = *haps[2 * sel[j]], &j2 = *haps[2 * sel[j] + 1];
+    f[j] = (double)ibd_shared(j1, j2, m) / m;
+    K[j * n + j] = 1 + f[j];
+    for (size_t i = 0; i < j; i++) {
+      const vector<IbdRun> &i1 = *haps[2 * sel[i]], &i2 = *haps[2 * sel[i] + 1];
+      double s = ibd_shared(i1, j1, m) + ibd_shared(i1, j2, m) + ibd_shared(i2, j1, m) + ibd_shared(i2, j2, m);
+      K[j * n + i] = K[i * n + j] = s / (2.0 * m);
+    }
+    if ( ! Progress::check_abort() ) { p.increment(); }
+  }
+
+  return List::create(_["kin"] = kin, _["F"] = F);
+}
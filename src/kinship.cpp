@@ -0,0 +1,352 @@
+#include "kinship.h"
+#include "MinimalProgressBar.h"
+
+// [[Rcpp::plugins(cpp11)]]
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::depends(bigmemory, BH)]]
+using namespace std;
+using namespace Rcpp;
+using namespace arma;
+
+template <typename T>
+arma::mat grm_kinship(XPtr<BigMatrix> pMat, std::string method="VanRaden", double memLimit=256, int threads=0, bool verbose=true) {
+  omp_setup(threads);
+
+  MatrixAccessor<T> bigm = MatrixAccessor<T>(*pMat);
+  KinMethod kin = kin_method(method);
+  if (kin == KIN_EMMA) {
+    Rcpp::stop("'method' should be 'VanRaden' or 'Yang'!");
+  }
+  size_t m = pMat->nrow(), n = pMat->ncol();
+  vector<T*> cols(n);
+  for (size_t j = 0; j < n; j++) { cols[j] = bigm[j]; }
+
+  arma::mat K(n, n, fill::zeros);
+  vector<double> Z, diag(n, 0);
+
+  vector<double> freq = kin_freq<T>(bigm, m, n);
+  double denom = kin_scale(freq, kin);
+  if (denom <= 0) {
+    Rcpp::stop("all markers are monomorphic!");
+  }
+
+  size_t nb = kin_block_rows(m, n, memLimit);
+  size_t nBlock = (m + nb - 1) / nb;
+
+  MinimalProgressBar pb;
+  Progress p(nBlock, verbose, pb);
+
+  if (verbose) { Rcout << " Computing " << method << " Kinship Matrix..." << endl; }
+
+  // Z'Z is accumulated block by block with BLAS
+  for (size_t b = 0; b < nBlock; b++) {
+    size_t k0 = b * nb, k1 = min(m, k0 + nb);
+    kin_block<T>(cols, k0, k1, kin, freq, Z, kin == KIN_YANG ? &diag : NULL);
+    kin_syrk(Z, k1 - k0, n, K.memptr(), n);
+    if ( ! Progress::check_abort() ) { p.increment(); }
+  }
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t j = 0; j < n; j++) {
+    for (size_t i = 0; i < j; i++) {
+      K(i, j) /= denom;
+      K(j, i) = K(i, j);
+    }
+    if (kin == KIN_YANG) {
+      K(j, j) = 1 + diag[j] / denom;
+    } else {
+      K(j, j) /= denom;
+    }
+  }
+
+  return K;
+}
+
+// [[Rcpp::export]]
+arma::mat grm_kinship(SEXP pBigMat, std::string method="VanRaden", double memLimit=256, int threads=0, bool verbose=true) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+
+  switch(xpMat->matrix_type()) {
+  case 1:
+    return grm_kinship<char>(xpMat, method, memLimit, threads, verbose);
+  case 2:
+    return grm_kinship<short>(xpMat, method, memLimit, threads, verbose);
+  case 4:
+    return grm_kinship<int>(xpMat, method, memLimit, threads, verbose);
+  case 8:
+    return grm_kinship<double>(xpMat, method, memLimit, threads, verbose);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
+
+// Reference of every marker that the kinship is standardized with: the
+// marker mean of EMMA, or the allele frequency of VanRaden and Yang. It is
+// kept with the kinship, so that the kinship can be grown later on.
+// [[Rcpp::export]]
+NumericVector KinshipRef(SEXP pBigMat, std::string method="EMMA", int threads=0) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+  omp_setup(threads);
+  size_t m = xpMat->nrow(), n = xpMat->ncol();
+
+  if (kin_method(method) == KIN_EMMA) {
+    arma::vec mean = BigRowMean(pBigMat, threads);
+    return NumericVector(mean.begin(), mean.end());
+  }
+
+  vector<double> freq;
+  switch(xpMat->matrix_type()) {
+  case 1: {
+    MatrixAccessor<char> bigm = MatrixAccessor<char>(*xpMat);
+    freq = kin_freq<char>(bigm, m, n); break;
+  }
+  case 2: {
+    MatrixAccessor<short> bigm = MatrixAccessor<short>(*xpMat);
+    freq = kin_freq<short>(bigm, m, n); break;
+  }
+  case 4: {
+    MatrixAccessor<int> bigm = MatrixAccessor<int>(*xpMat);
+    freq = kin_freq<int>(bigm, m, n); break;
+  }
+  case 8: {
+    MatrixAccessor<double> bigm = MatrixAccessor<double>(*xpMat);
+    freq = kin_freq<double>(bigm, m, n); break;
+  }
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+  return wrap(freq);
+}
+
+// Compute the output tiles 'tiles' of the kinship of the individuals 'cols'
+// and hand them to the sink (big.matrix or packed file) at once. A tile accumulates
+// over marker blocks of its two individual sets:
+//   EMMA    : popcount IBS of the bit planes of both sets;
+//   GRM     : Zr'Zr (dsyrk) on the diagonal, Zr'Zc (dgemm) elsewhere.
+// Only one tile and the genotype blocks of its two sets are in memory.
+template <typename T, typename S>
+void kinship_tiles(S &sink, const vector<T*> &cols, size_t m, const vector<PairTile> &tiles,
+                   KinMethod kin, const vector<double> &ref, double memLimit, bool verbose) {
+  double denom = kin == KIN_EMMA ? 2.0 * m : kin_scale(ref, kin);
+  if (denom <= 0) {
+    Rcpp::stop("all markers are monomorphic!");
+  }
+  size_t emmaBlock = 256 * 64;
+  vector<double> Zr, Zc, buf, diag;
+  EmmaPlanes Pr, Pc;
+  vector<uint64_t> M1;
+
+  MinimalProgressBar pb;
+  Progress p(tiles.size(), verbose, pb);
+
+  for (size_t tt = 0; tt < tiles.size(); tt++) {
+    const PairTile &tl = tiles[tt];
+    size_t tr = tl.r1 - tl.r0, tc = tl.c1 - tl.c0;
+    bool diagTile = (tl.r0 == tl.c0);
+    vector<T*> rcols(cols.begin() + tl.r0, cols.begin() + tl.r1);
+    vector<T*> ccols(cols.begin() + tl.c0, cols.begin() + tl.c1);
+    buf.assign(tr * tc, 0);
+    diag.assign(tr, 0);
+
+    if (kin == KIN_EMMA) {
+      vector<PairTile> sub = sub_tiles(tr, tc, diagTile);
+      for (size_t k0 = 0; k0 < m; k0 += emmaBlock) {
+        size_t k1 = min(m, k0 + emmaBlock);
+        emma_pack<T>(rcols, k0, k1, Pr);
+        if (!diagTile) { emma_pack<T>(ccols, k0, k1, Pc); }
+        const EmmaPlanes &Q = diagTile ? Pr : Pc;
+        emma_m1(ref, k0, k1, M1);
+
+        #pragma omp parallel for schedule(dynamic)
+        for (size_t ss = 0; ss < sub.size(); ss++) {
+          const PairTile &s = sub[ss];
+          for (size_t j = s.c0; j < s.c1; j++) {
+            size_t iEnd = diagTile ? min(s.r1, j) : s.r1;
+            for (size_t i = s.r0; i < iEnd; i++) {
+              buf[j * tr + i] += emma_ibs2(Pr, i, Q, j, M1);
+            }
+          }
+        }
+      }
+    } else {
+      size_t nb = kin_block_rows(m, diagTile ? tr : tr + tc, memLimit);
+      for (size_t k0 = 0; k0 < m; k0 += nb) {
+        size_t k1 = min(m, k0 + nb);
+        kin_block<T>(rcols, k0, k1, kin, ref, Zr, (diagTile && kin == KIN_YANG) ? &diag : NULL);
+        if (diagTile) {
+          kin_syrk(Zr, k1 - k0, tr, buf.data(), tr);
+        } else {
+          kin_block<T>(ccols, k0, k1, kin, ref, Zc, NULL);
+          kin_gemm(Zr, tr, Zc, tc, k1 - k0, buf.data(), tr);
+        }
+      }
+    }
+
+    sink.tile(buf, tl.r0, tl.r1, tl.c0, tl.c1, denom);
+    if (diagTile && kin != KIN_VANRADEN) {
+      for (size_t j = tl.c0; j < tl.c1; j++) {
+        sink.diag(j, kin == KIN_EMMA ? 1 : 1 + diag[j - tl.c0] / denom);
+      }
+    }
+    if ( ! Progress::check_abort() ) { p.increment(); }
+  }
+}
+
+// Kinship of the individuals of 'mats' (big.matrix objects of the same
+// markers, their columns following one another), of which only the pairs
+// with an individual beyond the first 'nOld' ones are computed: all pairs
+// when nOld is 0.
+template <typename T, typename S>
+void kinship_fill(S &sink, const vector<XPtr<BigMatrix> > &mats, size_t nOld, const vector<double> &ref, KinMethod kin, double memLimit, bool verbose) {
+  size_t m = mats[0]->nrow();
+  vector<T*> cols;
+  for (size_t b = 0; b < mats.size(); b++) {
+    MatrixAccessor<T> bigm = MatrixAccessor<T>(*mats[b]);
+    for (size_t j = 0; j < (size_t)mats[b]->ncol(); j++) { cols.push_back(bigm[j]); }
+  }
+  size_t N = cols.size();
+
+  vector<PairTile> tiles = append_tiles(nOld, N, kin_tile_size(N, memLimit));
+  if (verbose) {
+    if (nOld > 0) {
+      Rcout << " Appending " << N - nOld << " individuals to Kinship Matrix in " << tiles.size() << " tiles..." << endl;
+    } else {
+      Rcout << " Computing Kinship Matrix in " << tiles.size() << " tiles..." << endl;
+    }
+  }
+  kinship_tiles<T>(sink, cols, m, tiles, kin, ref, memLimit, verbose);
+}
+
+template <typename S>
+void kinship_fill(S &sink, const vector<XPtr<BigMatrix> > &mats, size_t nOld, NumericVector ref, std::string method, double memLimit, bool verbose) {
+  for (size_t b = 1; b < mats.size(); b++) {
+    if (mats[b]->matrix_type() != mats[0]->matrix_type() || mats[b]->nrow() != mats[0]->nrow()) {
+      Rcpp::stop("the old and new genotype should have the same type and marker number!");
+    }
+  }
+  if (ref.size() != mats[0]->nrow()) {
+    Rcpp::stop("'ref' should have the same length as marker number!");
+  }
+  KinMethod kin = kin_method(method);
+  vector<double> r(ref.begin(), ref.end());
+
+  switch(mats[0]->matrix_type()) {
+  case 1:
+    return kinship_fill<char, S>(sink, mats, nOld, r, kin, memLimit, verbose);
+  case 2:
+    return kinship_fill<short, S>(sink, mats, nOld, r, kin, memLimit, verbose);
+  case 4:
+    return kinship_fill<int, S>(sink, mats, nOld, r, kin, memLimit, verbose);
+  case 8:
+    return kinship_fill<double, S>(sink, mats, nOld, r, kin, memLimit, verbose);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
+
+static void kin_check_big(XPtr<BigMatrix> xpKin, size_t N) {
+  if (xpKin->matrix_type() != 8) {
+    Rcpp::stop("the kinship big.matrix should be of type 'double'!");
+  }
+  if ((size_t)xpKin->nrow() != N || (size_t)xpKin->ncol() != N) {
+    Rcpp::stop("the kinship big.matrix should be n x n, n being the total column number of genotype!");
+  }
+}
+
+// [[Rcpp::export]]
+void KinshipTiled(SEXP pKin, SEXP pBigMat, NumericVector ref, std::string method="EMMA", double memLimit=1024, int threads=0, bool verbose=true) {
+  XPtr<BigMatrix> xpKin(pKin);
+  vector<XPtr<BigMatrix> > mats(1, XPtr<BigMatrix>(pBigMat));
+  omp_setup(threads);
+
+  kin_check_big(xpKin, mats[0]->ncol());
+  MatrixAccessor<double> kinm = MatrixAccessor<double>(*xpKin);
+  BigKinSink sink(kinm);
+  kinship_fill(sink, mats, 0, ref, method, memLimit, verbose);
+}
+
+// the same as KinshipTiled, into a packed float32 file of the upper triangle
+// [[Rcpp::export]]
+void KinshipTiledPacked(std::string kin_file, SEXP pBigMat, NumericVector ref, std::string method="EMMA", double memLimit=1024, int threads=0, bool verbose=true) {
+  vector<XPtr<BigMatrix> > mats(1, XPtr<BigMatrix>(pBigMat));
+  omp_setup(threads);
+
+  PackedSym::create(kin_file, mats[0]->ncol());
+  PackedSym pk;
+  pk.open(kin_file, true);
+  PackedKinSink sink(pk);
+  kinship_fill(sink, mats, 0, ref, method, memLimit, verbose);
+  pk.flush();
+}
+
+// Fill the blocks of the new individuals of a kinship grown from n to n + k
+// individuals: the n x k cross block and the k x k block. The kinship among
+// the n old individuals is left as it is, 'ref' being the reference of the
+// markers it has been computed with (see KinshipRef).
+// [[Rcpp::export]]
+void KinshipAppend(SEXP pKin, SEXP pOldMat, SEXP pNewMat, NumericVector ref, std::string method="EMMA", double memLimit=1024, int threads=0, bool verbose=true) {
+  XPtr<BigMatrix> xpKin(pKin);
+  vector<XPtr<BigMatrix> > mats;
+  mats.push_back(XPtr<BigMatrix>(pOldMat));
+  mats.push_back(XPtr<BigMatrix>(pNewMat));
+  omp_setup(threads);
+
+  kin_check_big(xpKin, mats[0]->ncol() + mats[1]->ncol());
+  MatrixAccessor<double> kinm = MatrixAccessor<double>(*xpKin);
+  BigKinSink sink(kinm);
+  kinship_fill(sink, mats, mats[0]->ncol(), ref, method, memLimit, verbose);
+}
+
+// The same as KinshipAppend on a packed file, which grows by appending the
+// new columns, so nothing of the old kinship moves.
+// [[Rcpp::export]]
+void KinshipAppendPacked(std::string kin_file, SEXP pOldMat, SEXP pNewMat, NumericVector ref, std::string method="EMMA", double memLimit=1024, int threads=0, bool verbose=true) {
+  vector<XPtr<BigMatrix> > mats;
+  mats.push_back(XPtr<BigMatrix>(pOldMat));
+  mats.push_back(XPtr<BigMatrix>(pNewMat));
+  omp_setup(threads);
+
+  size_t n = mats[0]->ncol(), N = n + mats[1]->ncol();
+  if (PackedSym::dim(kin_file) != n) {
+    Rcpp::stop("the packed kinship should be of the individuals of the old genotype!");
+  }
+  PackedSym::create(kin_file, N, true);
+  PackedSym pk;
+  pk.open(kin_file, true);
+  PackedKinSink sink(pk);
+  kinship_fill(sink, mats, n, ref, method, memLimit, verbose);
+  pk.flush();
+}
+
+// Grow the backing file of a n x n double kinship to (n + k) x (n + k) in
+// place. The file is column-major, and every old column moves to a larger
+// offset, so the columns are moved from the last one to the first one. The
+// new cells are left to KinshipAppend.
+// [[Rcpp::export]]
+void KinshipGrow(std::string bin_file, double n, double k, bool verbose=true) {
+  int64_t n0 = (int64_t)n, N = n0 + (int64_t)k;
+  FILE *f = fopen(bin_file.c_str(), "r+b");
+  if (f == NULL) {
+    Rcpp::stop("cannot open file: %s", bin_file.c_str());
+  }
+
+  // extend the file first
+  double zero = 0;
+  if (simer_fseek(f, (N * N - 1) * 8) != 0 || fwrite(&zero, 8, 1, f) != 1) {
+    fclose(f);
+    Rcpp::stop("cannot grow file: %s", bin_file.c_str());
+  }
+
+  vector<double> col(n0);
+  MinimalProgressBar pb;
+  Progress p(n0, verbose, pb);
+  for (int64_t j = n0 - 1; j >= 0; j--) {
+    if (simer_fseek(f, j * n0 * 8) != 0 || fread(col.data(), 8, n0, f) != (size_t)n0 ||
+        simer_fseek(f, j * N * 8) != 0 || fwrite(col.data(), 8, n0, f) != (size_t)n0) {
+      fclose(f);
+      Rcpp::stop("cannot move columns of file: %s", bin_file.c_str());
+    }
+    if ( ! Progress::check_abort() ) { p.increment(); }
+  }
+  fclose(f);
+}
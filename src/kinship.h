@@ -0,0 +1,349 @@
+#ifndef SIMER_KINSHIP_H_
+#define SIMER_KINSHIP_H_
+
+#ifndef USE_FC_LEN_T
+#define USE_FC_LEN_T
+#endif
+#include <RcppArmadillo.h>
+#include <R_ext/BLAS.h>
+#ifndef FCONE
+#define FCONE
+#endif
+
+#include <bigmemory/BigMatrix.h>
+#include <bigmemory/MatrixAccessor.hpp>
+#include "simer_omp.h"
+#include "bitpack.h"
+#include "packed.h"
+
+// [[Rcpp::plugins(cpp11)]]
+
+// Kinship methods
+//   KIN_EMMA    : IBS similarity of EMMA, see emma_ibs2
+//   KIN_VANRADEN: Z = X - 2p, G = ZZ' / sum(2p(1 - p))
+//   KIN_YANG    : Z = (X - 2p) / sqrt(2p(1 - p)), G = ZZ' / m, with the
+//                 diagonal of GCTA 1 + sum(x^2 - (1 + 2p)x + 2p^2) / (2p(1 - p)) / m,
+//                 m being the number of polymorphic markers as in GCTA
+enum KinMethod { KIN_EMMA = 0, KIN_VANRADEN = 1, KIN_YANG = 2 };
+
+static inline KinMethod kin_method(std::string method) {
+  if (method == "EMMA") { return KIN_EMMA; }
+  if (method == "VanRaden") { return KIN_VANRADEN; }
+  if (method == "Yang") { return KIN_YANG; }
+  Rcpp::stop("'method' should be 'EMMA', 'VanRaden' or 'Yang'!");
+  return KIN_VANRADEN;
+}
+
+// Frequency p of allele '1' of every marker over n individuals, from the
+// observed 0/1/2 codes; an individual takes 'incols' columns (2 for
+// haplotypes) summed up. Rows are processed in blocks so that every column
+// contributes a contiguous piece.
+template <typename T>
+std::vector<double> kin_freq(MatrixAccessor<T> &bigm, size_t m, size_t n, size_t incols = 1) {
+  std::vector<double> freq(m, 0);
+  size_t bsize = 4096;
+  size_t nblock = (m + bsize - 1) / bsize;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t b = 0; b < nblock; b++) {
+    size_t r0 = b * bsize, r1 = std::min(m, r0 + bsize);
+    std::vector<double> sum(r1 - r0, 0), cnt(r1 - r0, 0);
+    for (size_t j = 0; j < n; j++) {
+      T *col = bigm[j * incols];
+      for (size_t k = r0; k < r1; k++) {
+        T x = col[k];
+        for (size_t h = 1; h < incols; h++) { x += bigm[j * incols + h][k]; }
+        if (x == 0 || x == 1 || x == 2) { sum[k - r0] += x; cnt[k - r0] += 1; }
+      }
+    }
+    for (size_t k = r0; k < r1; k++) {
+      freq[k] = cnt[k - r0] > 0 ? sum[k - r0] / cnt[k - r0] / 2 : 0;
+    }
+  }
+  return freq;
+}
+
+// denominator of the GRM; monomorphic markers are skipped by kin_block,
+// so that Yang counts only the polymorphic ones
+static inline double kin_scale(const std::vector<double> &freq, KinMethod method) {
+  double s = 0;
+  for (size_t k = 0; k < freq.size(); k++) {
+    double v = 2 * freq[k] * (1 - freq[k]);
+    if (method == KIN_YANG) {
+      s += v > 0;
+    } else {
+      s += v;
+    }
+  }
+  return s;
+}
+
+// Standardized genotype of markers [k0, k1) of the individuals 'cols'
+// (genotype columns, possibly of different big.matrix objects), stored as a
+// (k1 - k0) x cols.size() column-major block. Missing genotypes (any code
+// other than 0/1/2) are set to the mean, that is 0. 'diag' (if not NULL)
+// receives the GCTA diagonal terms of Yang. With 'incols' = 2 the columns
+// are haplotypes, two of which make an individual.
+template <typename T>
+void kin_block(const std::vector<T*> &cols, size_t k0, size_t k1, KinMethod method,
+               const std::vector<double> &freq, std::vector<double> &Z, std::vector<double> *diag, size_t incols = 1) {
+  size_t nb = k1 - k0, n = cols.size() / incols;
+  Z.assign(nb * n, 0);
+
+  #pragma omp parallel for schedule(static)
+  for (size_t j = 0; j < n; j++) {
+    T *col = cols[j * incols];
+    double *z = &Z[j * nb];
+    double d = 0;
+    for (size_t k = 0; k < nb; k++) {
+      T x = col[k0 + k];
+      for (size_t h = 1; h < incols; h++) { x += cols[j * incols + h][k0 + k]; }
+      if (!(x == 0 || x == 1 || x == 2)) { continue; }
+      double p = freq[k0 + k];
+      if (method == KIN_YANG) {
+        double v = 2 * p * (1 - p);
+        if (v <= 0) { continue; }
+        z[k] = (x - 2 * p) / sqrt(v);
+        d += (x * x - (1 + 2 * p) * x + 2 * p * p) / v;
+      } else {
+        z[k] = x - 2 * p;
+      }
+    }
+    if (diag) { (*diag)[j] += d; }
+  }
+}
+
+// C += Z'Z for a nb x n column-major block Z, upper triangle only
+static inline void kin_syrk(const std::vector<double> &Z, size_t nb, size_t n, double *C, size_t ldc) {
+  if (nb == 0 || n == 0) { return; }
+  int in = n, ik = nb, ildc = ldc;
+  double one = 1.0;
+  F77_CALL(dsyrk)("U", "T", &in, &ik, &one, Z.data(), &ik, &one, C, &ildc FCONE FCONE);
+}
+
+// C = op(A) op(B) + beta C, column-major, with A, B and C of leading
+// dimensions lda, ldb and ldc
+static inline void blas_gemm(const char *ta, const char *tb, size_t M, size_t N, size_t K, const double *A, size_t lda,
+                             const double *B, size_t ldb, double beta, double *C, size_t ldc) {
+  if (M == 0 || N == 0) { return; }
+  int iM = M, iN = N, iK = K, ilda = lda, ildb = ldb, ildc = ldc;
+  double one = 1.0;
+  F77_CALL(dgemm)(ta, tb, &iM, &iN, &iK, &one, A, &ilda, B, &ildb, &beta, C, &ildc FCONE FCONE);
+}
+
+// C += Zr'Zc for blocks of the same markers on two sets of individuals
+static inline void kin_gemm(const std::vector<double> &Zr, size_t nr, const std::vector<double> &Zc, size_t nc, size_t nb, double *C, size_t ldc) {
+  if (nb == 0) { return; }
+  blas_gemm("T", "N", nr, nc, nb, Zr.data(), nb, Zc.data(), nb, 1.0, C, ldc);
+}
+
+// Genotype codes of a block of markers packed per individual, 64 markers
+// per word: z (0), o (1), t (2), and x (any other code, such as NA). NaN
+// is in no plane, as it equals nothing, not even itself. The other codes
+// are also kept by value, so that two of them are identical only if their
+// values are; 'xone' tells that all of them are of the value 'x0', as the
+// NA code of an integer matrix nearly always is.
+struct EmmaPlanes {
+  size_t nw;
+  std::vector<uint64_t> z, o, t, x;
+  std::vector< std::vector< std::pair<uint32_t, double> > > xv;
+  bool xone;
+  double x0;
+
+  void init(size_t n, size_t w) {
+    nw = w;
+    z.assign(n * w, 0); o.assign(n * w, 0);
+    t.assign(n * w, 0); x.assign(n * w, 0);
+    xv.assign(n, std::vector< std::pair<uint32_t, double> >());
+    xone = true;
+    x0 = 0;
+  }
+
+  // value of the other code of individual i at marker k of the block
+  double xval(size_t i, uint32_t k) const {
+    const std::vector< std::pair<uint32_t, double> > &v = xv[i];
+    return std::lower_bound(v.begin(), v.end(), std::make_pair(k, -HUGE_VAL))->second;
+  }
+};
+
+// Pack the markers [k0, k1) of the individuals 'cols' into planes.
+template <typename T>
+void emma_pack(const std::vector<T*> &cols, size_t k0, size_t k1, EmmaPlanes &P) {
+  size_t nw = (k1 - k0 + 63) / 64;
+  size_t n = cols.size();
+  P.init(n, nw);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < n; i++) {
+    T *col = cols[i];
+    uint64_t *z = &P.z[i * nw], *o = &P.o[i * nw], *t = &P.t[i * nw], *x = &P.x[i * nw];
+    for (size_t k = k0; k < k1; k++) {
+      uint64_t bit = 1ULL << ((k - k0) % 64);
+      size_t w = (k - k0) / 64;
+      T g = col[k];
+      if (g == 0) {
+        z[w] |= bit;
+      } else if (g == 1) {
+        o[w] |= bit;
+      } else if (g == 2) {
+        t[w] |= bit;
+      } else if (g == g) {
+        x[w] |= bit;
+        P.xv[i].push_back(std::make_pair((uint32_t)(k - k0), (double)g));
+      }
+    }
+  }
+
+  bool first = true;
+  for (size_t i = 0; i < n && P.xone; i++) {
+    for (size_t r = 0; r < P.xv[i].size(); r++) {
+      if (first) { P.x0 = P.xv[i][r].second; first = false; }
+      if (P.xv[i][r].second != P.x0) { P.xone = false; break; }
+    }
+  }
+}
+
+// markers of the block whose mean over all individuals is exactly 1
+template <typename V>
+void emma_m1(const V &rowMeans, size_t k0, size_t k1, std::vector<uint64_t> &M1) {
+  M1.assign((k1 - k0 + 63) / 64, 0);
+  for (size_t k = k0; k < k1; k++) {
+    if (rowMeans[k] == 1) { M1[(k - k0) / 64] |= 1ULL << ((k - k0) % 64); }
+  }
+}
+
+// IBS similarity of individual i of planes Pi and individual j of planes Pj
+// over the packed block:
+//   identical codes (NaN excluded)   -> 1
+//   one of them is 1, marker mean 1  -> 1 if the other is 0
+//   one of them is 1, otherwise      -> 0.5
+//   0 vs 2 (or 1 vs other on M1)     -> 0
+// twice the similarity is returned so that the sum stays integral.
+static inline double emma_ibs2(const EmmaPlanes &Pi, size_t i, const EmmaPlanes &Pj, size_t j, const std::vector<uint64_t> &M1) {
+  size_t nw = Pi.nw;
+  const uint64_t *zi = &Pi.z[i * nw], *oi = &Pi.o[i * nw], *ti = &Pi.t[i * nw], *xi = &Pi.x[i * nw];
+  const uint64_t *zj = &Pj.z[j * nw], *oj = &Pj.o[j * nw], *tj = &Pj.t[j * nw], *xj = &Pj.x[j * nw];
+  bool xsame = Pi.xone && Pj.xone && Pi.x0 == Pj.x0;
+  size_t s = 0;
+  for (size_t w = 0; w < nw; w++) {
+    uint64_t eq = (zi[w] & zj[w]) | (oi[w] & oj[w]) | (ti[w] & tj[w]);
+    uint64_t ex = xi[w] & xj[w];
+    uint64_t one = oi[w] ^ oj[w];
+    uint64_t m1 = M1[w];
+    s += 2 * popcnt64(eq);
+    if (xsame) {
+      s += 2 * popcnt64(ex);
+    } else {
+      for (; ex; ex &= ex - 1) {
+        uint32_t k = w * 64 + ctz64(ex);
+        if (Pi.xval(i, k) == Pj.xval(j, k)) { s += 2; }
+      }
+    }
+    s += 2 * popcnt64(m1 & ((oi[w] & zj[w]) | (zi[w] & oj[w])));
+    s += popcnt64(one & ~m1);
+  }
+  return (double)s;
+}
+
+// Output tiles of the kinship: tiles of 'tile' individuals, so that a tile
+// and the genotype blocks of its two individual sets fit in memLimit MB.
+static inline size_t kin_tile_size(size_t n, double memLimit) {
+  double t = sqrt(memLimit * 1024 * 1024 / 2 / 8);
+  size_t tile = static_cast<size_t>(t) / 64 * 64;
+  if (tile < 64) { tile = 64; }
+  return std::min(tile, std::max(n, (size_t)1));
+}
+
+// markers per genotype block of 'ncols' individuals within memLimit / 2 MB
+static inline size_t kin_block_rows(size_t m, size_t ncols, double memLimit) {
+  double nb = memLimit * 1024 * 1024 / 2 / (8.0 * std::max(ncols, (size_t)1));
+  if (nb < 64) { nb = 64; }
+  if (nb > m) { nb = m; }
+  return static_cast<size_t>(nb);
+}
+
+// Write a tile (column-major, rows [r0, r1) x columns [c0, c1)) divided
+// by 'denom' into the kinship and its mirror. On a diagonal tile only the
+// upper triangle of the buffer is valid.
+static inline void kin_write_tile(MatrixAccessor<double> &kin, const std::vector<double> &buf, size_t r0, size_t r1, size_t c0, size_t c1, double denom) {
+  size_t tr = r1 - r0;
+  bool diagTile = (r0 == c0);
+
+  #pragma omp parallel for schedule(static)
+  for (size_t c = c0; c < c1; c++) {
+    size_t rEnd = diagTile ? c + 1 : r1;
+    double *col = kin[c];
+    for (size_t r = r0; r < rEnd; r++) { col[r] = buf[(c - c0) * tr + (r - r0)] / denom; }
+  }
+  #pragma omp parallel for schedule(static)
+  for (size_t r = r0; r < r1; r++) {
+    size_t cStart = diagTile ? r + 1 : c0;
+    double *col = kin[r];
+    for (size_t c = cStart; c < c1; c++) { col[c] = buf[(c - c0) * tr + (r - r0)] / denom; }
+  }
+}
+
+// Destinations of the finished tiles: a n x n double big.matrix, where a
+// tile is written with its mirror, or a packed file, where only the upper
+// triangle is kept.
+struct BigKinSink {
+  MatrixAccessor<double> &kin;
+  BigKinSink(MatrixAccessor<double> &k) : kin(k) {}
+  void tile(const std::vector<double> &buf, size_t r0, size_t r1, size_t c0, size_t c1, double denom) {
+    kin_write_tile(kin, buf, r0, r1, c0, c1, denom);
+  }
+  void diag(size_t j, double v) { kin[j][j] = v; }
+};
+
+struct PackedKinSink {
+  PackedSym &pk;
+  PackedKinSink(PackedSym &p) : pk(p) {}
+  void tile(const std::vector<double> &buf, size_t r0, size_t r1, size_t c0, size_t c1, double denom) {
+    size_t tr = r1 - r0;
+    bool diagTile = (r0 == c0);
+    #pragma omp parallel for schedule(static)
+    for (size_t c = c0; c < c1; c++) {
+      size_t rEnd = diagTile ? c + 1 : r1;
+      float *col = pk.data + PackedSym::index(r0, c);
+      for (size_t r = r0; r < rEnd; r++) { col[r - r0] = buf[(c - c0) * tr + (r - r0)] / denom; }
+    }
+  }
+  void diag(size_t j, double v) { pk.set(j, j, v); }
+};
+
+// Tiles of the kinship grown from n to N individuals: only the pairs with
+// at least one new individual (column index >= n) are covered.
+static inline std::vector<PairTile> append_tiles(size_t n, size_t N, size_t tile) {
+  std::vector<PairTile> tiles;
+  if (tile == 0) { tile = 1; }
+  for (size_t c0 = n; c0 < N; c0 += tile) {
+    size_t c1 = std::min(N, c0 + tile);
+    for (size_t r0 = 0; r0 < n; r0 += tile) {
+      PairTile t = { r0, std::min(n, r0 + tile), c0, c1 };
+      tiles.push_back(t);
+    }
+    for (size_t r0 = n; r0 <= c0; r0 += tile) {
+      PairTile t = { r0, std::min(N, r0 + tile), c0, c1 };
+      tiles.push_back(t);
+    }
+  }
+  return tiles;
+}
+
+// 64 x 64 sub-tiles of a tr x tc output tile, upper triangle only on the
+// diagonal, so that the planes of both individual sets stay in cache
+static inline std::vector<PairTile> sub_tiles(size_t tr, size_t tc, bool diagTile) {
+  if (diagTile) { return upper_tiles(tr, 64); }
+  std::vector<PairTile> sub;
+  for (size_t r0 = 0; r0 < tr; r0 += 64) {
+    for (size_t c0 = 0; c0 < tc; c0 += 64) {
+      PairTile s = { r0, std::min(tr, r0 + 64), c0, std::min(tc, c0 + 64) };
+      sub.push_back(s);
+    }
+  }
+  return sub;
+}
+
+arma::vec BigRowMean(SEXP pBigMat, int threads);
+
+#endif
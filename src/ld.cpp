@@ -0,0 +1,613 @@
+#include <RcppArmadillo.h>
+#include <boost/algorithm/string.hpp>
+#include <bigmemory/BigMatrix.h>
+#include <bigmemory/MatrixAccessor.hpp>
+#include "simer_omp.h"
+#include "bitpack.h"
+#include "MinimalProgressBar.h"
+
+// [[Rcpp::plugins(cpp11)]]
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::depends(bigmemory, BH)]]
+using namespace std;
+using namespace Rcpp;
+using namespace arma;
+
+// sums of a marker over all units, used when neither marker of a pair has
+// missing genotype
+struct LDMarkerSum {
+  vector<double> s1, s2;
+
+  void init(const BitGeno &g) {
+    s1.assign(g.nmrk, 0); s2.assign(g.nmrk, 0);
+    for (size_t k = 0; k < g.nmrk; k++) {
+      s1[k] = popcnt(g.A(k), g.nw);
+      if (!g.hap) { s2[k] = popcnt(g.B(k), g.nw); }
+    }
+  }
+};
+
+static inline double LDDprime(double D, double pA, double pB) {
+  double Dmax;
+  if (D > 0) {
+    Dmax = min(pA * (1 - pB), (1 - pA) * pB);
+  } else {
+    Dmax = min(pA * pB, (1 - pA) * (1 - pB));
+  }
+  return Dmax > 0 ? D / Dmax : NA_REAL;
+}
+
+// r2 and D' of markers k and l.
+// haplotype: D = pAB - pA * pB from allele counts;
+// dosage: r2 is the squared correlation of dosages, and D' is taken from
+// the composite disequilibrium cov(x, y) / 2 with pA = mean(x) / 2.
+static inline void LDPair(const BitGeno &g, const LDMarkerSum &ms, size_t k, size_t l, double &r2, double &dp) {
+  size_t nw = g.nw;
+  const uint64_t *ak = g.A(k), *al = g.A(l);
+  bool full = g.full[k] && g.full[l];
+
+  if (g.hap) {
+    double n, cA, cB, cAB = 0;
+    if (full) {
+      n = g.nunit; cA = ms.s1[k]; cB = ms.s1[l];
+      for (size_t w = 0; w < nw; w++) { cAB += popcnt64(ak[w] & al[w]); }
+    } else {
+      const uint64_t *vk = g.V(k), *vl = g.V(l);
+      n = 0; cA = 0; cB = 0;
+      for (size_t w = 0; w < nw; w++) {
+        n   += popcnt64(vk[w] & vl[w]);
+        cA  += popcnt64(ak[w] & vl[w]);
+        cB  += popcnt64(al[w] & vk[w]);
+        cAB += popcnt64(ak[w] & al[w]);
+      }
+    }
+    if (n == 0) { r2 = NA_REAL; dp = NA_REAL; return; }
+    double pA = cA / n, pB = cB / n;
+    double D = cAB / n - pA * pB;
+    double den = pA * (1 - pA) * pB * (1 - pB);
+    r2 = den > 0 ? D * D / den : NA_REAL;
+    dp = LDDprime(D, pA, pB);
+    return;
+  }
+
+  const uint64_t *bk = g.B(k), *bl = g.B(l);
+  double n, sx1, sx2, sy1, sy2, sxy = 0;
+  if (full) {
+    n = g.nunit;
+    sx1 = ms.s1[k]; sx2 = ms.s2[k];
+    sy1 = ms.s1[l]; sy2 = ms.s2[l];
+    for (size_t w = 0; w < nw; w++) {
+      sxy += popcnt64(ak[w] & al[w]) + popcnt64(ak[w] & bl[w]) + popcnt64(bk[w] & al[w]) + popcnt64(bk[w] & bl[w]);
+    }
+  } else {
+    const uint64_t *vk = g.V(k), *vl = g.V(l);
+    n = 0; sx1 = 0; sx2 = 0; sy1 = 0; sy2 = 0;
+    for (size_t w = 0; w < nw; w++) {
+      n   += popcnt64(vk[w] & vl[w]);
+      sx1 += popcnt64(ak[w] & vl[w]);
+      sx2 += popcnt64(bk[w] & vl[w]);
+      sy1 += popcnt64(al[w] & vk[w]);
+      sy2 += popcnt64(bl[w] & vk[w]);
+      sxy += popcnt64(ak[w] & al[w]) + popcnt64(ak[w] & bl[w]) + popcnt64(bk[w] & al[w]) + popcnt64(bk[w] & bl[w]);
+    }
+  }
+  if (n == 0) { r2 = NA_REAL; dp = NA_REAL; return; }
+  // x = a + b, x^2 = a + 3b since b implies a
+  double mx = (sx1 + sx2) / n, my = (sy1 + sy2) / n;
+  double vx = (sx1 + 3 * sx2) / n - mx * mx;
+  double vy = (sy1 + 3 * sy2) / n - my * my;
+  double cxy = sxy / n - mx * my;
+  r2 = (vx > 0 && vy > 0) ? cxy * cxy / (vx * vy) : NA_REAL;
+  dp = LDDprime(cxy / 2, mx / 2, my / 2);
+}
+
+template <typename T>
+List LDWindow(XPtr<BigMatrix> pMat, IntegerVector chrom, NumericVector pos, int incols=2, bool haplotype=true, int winSNP=100, double winBP=1e6, double binSize=1e5, bool keepPairs=false, int threads=0, bool verbose=true) {
+  omp_setup(threads);
+
+  size_t m = pMat->nrow();
+  if (chrom.size() != (int)m || pos.size() != (int)m) {
+    Rcpp::stop("'chrom' and 'pos' should have the same length as marker number!");
+  }
+  if (winSNP < 1) { Rcpp::stop("'winSNP' should be a positive integer!"); }
+  if (binSize <= 0) { Rcpp::stop("'binSize' should be positive!"); }
+  // R vectors are not touched inside the parallel region
+  vector<int> chr(chrom.begin(), chrom.end());
+  vector<double> bp(pos.begin(), pos.end());
+
+  if (verbose) { Rcout << " Packing genotype into bits..." << endl; }
+  BitGeno g;
+  bitgeno_pack<T>(g, pMat, incols, haplotype, threads);
+  LDMarkerSum ms;
+  ms.init(g);
+
+  size_t nBin = winBP > 0 ? (size_t)ceil(winBP / binSize) : 1;
+  if (nBin == 0) { nBin = 1; }
+  vector<double> binN(nBin, 0), binR2(nBin, 0), binDp(nBin, 0), binDpN(nBin, 0);
+  vector<int> pairI, pairJ;
+  vector<double> pairDist, pairR2, pairDp;
+
+  MinimalProgressBar pb;
+  Progress p(m, verbose, pb);
+
+  if (verbose) { Rcout << " Computing LD in sliding windows..." << endl; }
+
+  #pragma omp parallel
+  {
+    vector<double> lbinN(nBin, 0), lbinR2(nBin, 0), lbinDp(nBin, 0), lbinDpN(nBin, 0);
+    vector<int> lpairI, lpairJ;
+    vector<double> lpairDist, lpairR2, lpairDp;
+    double r2, dp;
+
+    #pragma omp for schedule(dynamic, 64)
+    for (size_t i = 0; i < m; i++) {
+      for (size_t j = i + 1; j < m && j <= i + winSNP; j++) {
+        if (chr[j] != chr[i]) { break; }
+        double dist = fabs(bp[j] - bp[i]);
+        if (winBP > 0 && dist > winBP) { break; }
+        LDPair(g, ms, i, j, r2, dp);
+        if (ISNAN(r2)) { continue; }
+        size_t bin = (size_t)(dist / binSize);
+        if (bin >= nBin) { bin = nBin - 1; }
+        lbinN[bin] += 1;
+        lbinR2[bin] += r2;
+        if (!ISNAN(dp)) {
+          lbinDp[bin] += fabs(dp);
+          lbinDpN[bin] += 1;
+        }
+        if (keepPairs) {
+          lpairI.push_back(i + 1);
+          lpairJ.push_back(j + 1);
+          lpairDist.push_back(dist);
+          lpairR2.push_back(r2);
+          lpairDp.push_back(dp);
+        }
+      }
+      if ( ! Progress::check_abort() ) { p.increment(); }
+    }
+
+    #pragma omp critical
+    {
+      for (size_t b = 0; b < nBin; b++) {
+        binN[b] += lbinN[b]; binR2[b] += lbinR2[b];
+        binDp[b] += lbinDp[b]; binDpN[b] += lbinDpN[b];
+      }
+      if (keepPairs) {
+        pairI.insert(pairI.end(), lpairI.begin(), lpairI.end());
+        pairJ.insert(pairJ.end(), lpairJ.begin(), lpairJ.end());
+        pairDist.insert(pairDist.end(), lpairDist.begin(), lpairDist.end());
+        pairR2.insert(pairR2.end(), lpairR2.begin(), lpairR2.end());
+        pairDp.insert(pairDp.end(), lpairDp.begin(), lpairDp.end());
+      }
+    }
+  }
+
+  NumericVector binStart(nBin), binEnd(nBin), meanR2(nBin), meanDp(nBin), numPair(nBin);
+  for (size_t b = 0; b < nBin; b++) {
+    binStart[b] = b * binSize;
+    binEnd[b] = (b + 1) * binSize;
+    numPair[b] = binN[b];
+    meanR2[b] = binN[b] > 0 ? binR2[b] / binN[b] : NA_REAL;
+    meanDp[b] = binDpN[b] > 0 ? binDp[b] / binDpN[b] : NA_REAL;
+  }
+  DataFrame decay = DataFrame::create(
+    Named("binStart") = binStart,
+    _["binEnd"]       = binEnd,
+    _["numPair"]      = numPair,
+    _["meanR2"]       = meanR2,
+    _["meanDprime"]   = meanDp
+  );
+
+  if (!keepPairs) {
+    return List::create(Named("decay") = decay, _["pairs"] = R_NilValue);
+  }
+
+  // threads finish their windows out of order
+  size_t np = pairI.size();
+  vector<size_t> ord(np);
+  for (size_t k = 0; k < np; k++) { ord[k] = k; }
+  std::sort(ord.begin(), ord.end(), [&](size_t x, size_t y) {
+    return pairI[x] != pairI[y] ? pairI[x] < pairI[y] : pairJ[x] < pairJ[y];
+  });
+  IntegerVector snp1(np), snp2(np);
+  NumericVector dist(np), r2(np), dp(np);
+  for (size_t k = 0; k < np; k++) {
+    snp1[k] = pairI[ord[k]]; snp2[k] = pairJ[ord[k]];
+    dist[k] = pairDist[ord[k]]; r2[k] = pairR2[ord[k]]; dp[k] = pairDp[ord[k]];
+  }
+  DataFrame pairs = DataFrame::create(
+    Named("SNP1")  = snp1,
+    _["SNP2"]      = snp2,
+    _["dist"]      = dist,
+    _["r2"]        = r2,
+    _["Dprime"]    = dp
+  );
+  return List::create(Named("decay") = decay, _["pairs"] = pairs);
+}
+
+// [[Rcpp::export]]
+List LDWindow(SEXP pBigMat, IntegerVector chrom, NumericVector pos, int incols=2, bool haplotype=true, int winSNP=100, double winBP=1e6, double binSize=1e5, bool keepPairs=false, int threads=0, bool verbose=true) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+
+  switch(xpMat->matrix_type()) {
+  case 1:
+    return LDWindow<char>(xpMat, chrom, pos, incols, haplotype, winSNP, winBP, binSize, keepPairs, threads, verbose);
+  case 2:
+    return LDWindow<short>(xpMat, chrom, pos, incols, haplotype, winSNP, winBP, binSize, keepPairs, threads, verbose);
+  case 4:
+    return LDWindow<int>(xpMat, chrom, pos, incols, haplotype, winSNP, winBP, binSize, keepPairs, threads, verbose);
+  case 8:
+    return LDWindow<double>(xpMat, chrom, pos, incols, haplotype, winSNP, winBP, binSize, keepPairs, threads, verbose);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
+
+template <typename T>
+List LDRegion(XPtr<BigMatrix> pMat, IntegerVector rowIdx, int incols=2, bool haplotype=true, int threads=0, bool verbose=true) {
+  omp_setup(threads);
+
+  size_t m = rowIdx.size();
+  if (m == 0) { Rcpp::stop("'rowIdx' should not be empty!"); }
+  if (min(rowIdx) < 1 || max(rowIdx) > pMat->nrow()) {
+    Rcpp::stop("'rowIdx' is out of bound!");
+  }
+  vector<size_t> rows(m);
+  for (size_t k = 0; k < m; k++) { rows[k] = rowIdx[k] - 1; }
+
+  BitGeno g;
+  bitgeno_pack<T>(g, pMat, rows, incols, haplotype, threads);
+  LDMarkerSum ms;
+  ms.init(g);
+
+  arma::mat r2(m, m, fill::ones), dp(m, m, fill::ones);
+  vector<PairTile> tiles = upper_tiles(m, 64);
+
+  MinimalProgressBar pb;
+  Progress p(tiles.size(), verbose, pb);
+
+  if (verbose) { Rcout << " Computing LD of all pairs in region..." << endl; }
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t t = 0; t < tiles.size(); t++) {
+    double r, d;
+    for (size_t i = tiles[t].r0; i < tiles[t].r1; i++) {
+      for (size_t j = max(i + 1, tiles[t].c0); j < tiles[t].c1; j++) {
+        LDPair(g, ms, i, j, r, d);
+        r2(i, j) = r; r2(j, i) = r;
+        dp(i, j) = d; dp(j, i) = d;
+      }
+    }
+    if ( ! Progress::check_abort() ) { p.increment(); }
+  }
+
+  return List::create(Named("r2") = r2, _["Dprime"] = dp);
+}
+
+// [[Rcpp::export]]
+List LDRegion(SEXP pBigMat, IntegerVector rowIdx, int incols=2, bool haplotype=true, int threads=0, bool verbose=true) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+
+  switch(xpMat->matrix_type()) {
+  case 1:
+    return LDRegion<char>(xpMat, rowIdx, incols, haplotype, threads, verbose);
+  case 2:
+    return LDRegion<short>(xpMat, rowIdx, incols, haplotype, threads, verbose);
+  case 4:
+    return LDRegion<int>(xpMat, rowIdx, incols, haplotype, threads, verbose);
+  case 8:
+    return LDRegion<double>(xpMat, rowIdx, incols, haplotype, threads, verbose);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
+
+// minor allele frequency of a packed marker over its observed units
+static inline double LDMaf(const BitGeno &g, const LDMarkerSum &ms, size_t k) {
+  double n = g.full[k] ? g.nunit : popcnt(g.V(k), g.nw);
+  if (n == 0) { return 0; }
+  double p = g.hap ? ms.s1[k] / n : (ms.s1[k] + ms.s2[k]) / (2 * n);
+  return p <= 0.5 ? p : 1 - p;
+}
+
+// markers (0-based) of every chromosome, in their original order
+static vector< vector<size_t> > LDGroupByChrom(IntegerVector chrom, const vector<size_t> &rows) {
+  std::map<int, size_t> chrIdx;
+  vector< vector<size_t> > groups;
+  for (size_t k = 0; k < rows.size(); k++) {
+    int c = chrom[rows[k]];
+    std::map<int, size_t>::iterator it = chrIdx.find(c);
+    if (it == chrIdx.end()) {
+      chrIdx[c] = groups.size();
+      groups.push_back(vector<size_t>(1, rows[k]));
+    } else {
+      groups[it->second].push_back(rows[k]);
+    }
+  }
+  return groups;
+}
+
+static vector<size_t> LDRows(Nullable<IntegerVector> rowIdx, size_t m) {
+  vector<size_t> rows;
+  if (rowIdx.isNull()) {
+    rows.resize(m);
+    for (size_t k = 0; k < m; k++) { rows[k] = k; }
+  } else {
+    IntegerVector ri = as<IntegerVector>(rowIdx);
+    rows.resize(ri.size());
+    for (size_t k = 0; k < rows.size(); k++) {
+      if (ri[k] < 1 || ri[k] > (int)m) { Rcpp::stop("'rowIdx' is out of bound!"); }
+      rows[k] = ri[k] - 1;
+    }
+  }
+  return rows;
+}
+
+// PLINK-like --indep-pairwise on one chromosome: in every window of winSNP
+// markers (moved by step markers), of each pair with r2 above r2Thres the
+// marker with lower MAF is removed.
+static void LDPruneChrom(const BitGeno &g, int winSNP, int step, double r2Thres, vector<unsigned char> &keep) {
+  size_t m = g.nmrk;
+  LDMarkerSum ms;
+  ms.init(g);
+  vector<double> maf(m);
+  for (size_t k = 0; k < m; k++) { maf[k] = LDMaf(g, ms, k); }
+  keep.assign(m, 1);
+
+  double r2, dp;
+  for (size_t op = 0; op < m; op += step) {
+    size_t ed = min(m, op + winSNP);
+    for (size_t i = op; i < ed; i++) {
+      if (!keep[i]) { continue; }
+      for (size_t j = i + 1; j < ed; j++) {
+        if (!keep[j]) { continue; }
+        LDPair(g, ms, i, j, r2, dp);
+        if (ISNAN(r2) || r2 <= r2Thres) { continue; }
+        if (maf[i] < maf[j]) {
+          keep[i] = 0;
+          break;
+        } else {
+          keep[j] = 0;
+        }
+      }
+    }
+    if (ed == m) { break; }
+  }
+}
+
+// PLINK-like --clump on one chromosome: markers with p-value below p1 are
+// taken as index markers from the most significant one, and every marker
+// within winBP with p-value below p2 and r2 above r2Thres joins its clump.
+// Positions are assumed sorted within the chromosome.
+static void LDClumpChrom(const BitGeno &g, const vector<double> &bp, const vector<double> &pval, double p1, double p2, double r2Thres, double winBP, vector<int> &index) {
+  size_t m = g.nmrk;
+  LDMarkerSum ms;
+  ms.init(g);
+  index.assign(m, -1);
+
+  vector<size_t> ord;
+  for (size_t k = 0; k < m; k++) {
+    if (!ISNAN(pval[k]) && pval[k] <= p1) { ord.push_back(k); }
+  }
+  std::stable_sort(ord.begin(), ord.end(), [&](size_t x, size_t y) { return pval[x] < pval[y]; });
+
+  double r2, dp;
+  for (size_t t = 0; t < ord.size(); t++) {
+    size_t i = ord[t];
+    if (index[i] >= 0) { continue; }
+    index[i] = i;
+    for (size_t j = i; j-- > 0; ) {
+      if (bp[i] - bp[j] > winBP) { break; }
+      if (index[j] >= 0 || ISNAN(pval[j]) || pval[j] > p2) { continue; }
+      LDPair(g, ms, i, j, r2, dp);
+      if (!ISNAN(r2) && r2 >= r2Thres) { index[j] = i; }
+    }
+    for (size_t j = i + 1; j < m; j++) {
+      if (bp[j] - bp[i] > winBP) { break; }
+      if (index[j] >= 0 || ISNAN(pval[j]) || pval[j] > p2) { continue; }
+      LDPair(g, ms, i, j, r2, dp);
+      if (!ISNAN(r2) && r2 >= r2Thres) { index[j] = i; }
+    }
+  }
+}
+
+// chromosomes are pruned in parallel, each packed on its own; the packer
+// returns false instead of throwing inside the parallel region
+template <typename Packer>
+IntegerVector LDPruneByChrom(Packer pack, const vector< vector<size_t> > &groups, int winSNP, int step, double r2Thres, int threads, bool verbose) {
+  omp_setup(threads);
+  if (winSNP < 2) { Rcpp::stop("'winSNP' should be at least 2!"); }
+  if (step < 1) { Rcpp::stop("'step' should be a positive integer!"); }
+
+  size_t ng = groups.size();
+  vector< vector<unsigned char> > keeps(ng);
+
+  MinimalProgressBar pb;
+  Progress p(ng, verbose, pb);
+
+  if (verbose) { Rcout << " Pruning markers by LD in " << ng << " chromosomes..." << endl; }
+
+  bool failed = false;
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t c = 0; c < ng; c++) {
+    BitGeno g;
+    if (!pack(g, groups[c])) {
+      #pragma omp atomic write
+      failed = true;
+      continue;
+    }
+    LDPruneChrom(g, winSNP, step, r2Thres, keeps[c]);
+    if ( ! Progress::check_abort() ) { p.increment(); }
+  }
+  if (failed) {
+    Rcpp::stop("cannot read the genotype!");
+  }
+
+  vector<int> keep;
+  for (size_t c = 0; c < ng; c++) {
+    for (size_t k = 0; k < groups[c].size(); k++) {
+      if (keeps[c][k]) { keep.push_back(groups[c][k] + 1); }
+    }
+  }
+  std::sort(keep.begin(), keep.end());
+  if (verbose) {
+    size_t total = 0;
+    for (size_t c = 0; c < ng; c++) { total += groups[c].size(); }
+    Rcout << " " << (total - keep.size()) << " variants removed due to LD (--indep-pairwise)." << endl;
+    Rcout << " " << keep.size() << " variants remaining." << endl;
+  }
+  return wrap(keep);
+}
+
+template <typename Packer>
+List LDClumpByChrom(Packer pack, const vector< vector<size_t> > &groups, NumericVector pos, NumericVector pval, double p1, double p2, double r2Thres, double winBP, int threads, bool verbose) {
+  omp_setup(threads);
+
+  size_t ng = groups.size();
+  vector< vector<int> > index(ng);
+  vector< vector<double> > bps(ng), pvs(ng);
+  for (size_t c = 0; c < ng; c++) {
+    for (size_t k = 0; k < groups[c].size(); k++) {
+      bps[c].push_back(pos[groups[c][k]]);
+      pvs[c].push_back(pval[groups[c][k]]);
+    }
+  }
+
+  MinimalProgressBar pb;
+  Progress p(ng, verbose, pb);
+
+  if (verbose) { Rcout << " Clumping markers by LD in " << ng << " chromosomes..." << endl; }
+
+  bool failed = false;
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t c = 0; c < ng; c++) {
+    BitGeno g;
+    if (!pack(g, groups[c])) {
+      #pragma omp atomic write
+      failed = true;
+      continue;
+    }
+    LDClumpChrom(g, bps[c], pvs[c], p1, p2, r2Thres, winBP, index[c]);
+    if ( ! Progress::check_abort() ) { p.increment(); }
+  }
+  if (failed) {
+    Rcpp::stop("cannot read the genotype!");
+  }
+
+  IntegerVector clump(pos.size(), NA_INTEGER);
+  vector<int> keep;
+  for (size_t c = 0; c < ng; c++) {
+    for (size_t k = 0; k < groups[c].size(); k++) {
+      if (index[c][k] < 0) { continue; }
+      clump[groups[c][k]] = groups[c][index[c][k]] + 1;
+      if (index[c][k] == (int)k) { keep.push_back(groups[c][k] + 1); }
+    }
+  }
+  std::sort(keep.begin(), keep.end());
+  if (verbose) {
+    Rcout << " " << keep.size() << " clumps formed." << endl;
+  }
+  return List::create(Named("keep") = wrap(keep), _["clump"] = clump);
+}
+
+template <typename T>
+IntegerVector LDPrune(XPtr<BigMatrix> pMat, IntegerVector chrom, Nullable<IntegerVector> rowIdx=R_NilValue, Nullable<IntegerVector> colIdx=R_NilValue, int incols=1, int winSNP=50, int step=5, double r2Thres=0.2, int threads=0, bool verbose=true) {
+  if (chrom.size() != pMat->nrow()) {
+    Rcpp::stop("'chrom' should have the same length as marker number!");
+  }
+  vector<size_t> rows = LDRows(rowIdx, pMat->nrow());
+  size_t nunit = incols == 2 ? pMat->ncol() / 2 : pMat->ncol();
+  vector<size_t> units = LDRows(colIdx, nunit);
+  if (colIdx.isNull()) { units.clear(); }
+  vector< vector<size_t> > groups = LDGroupByChrom(chrom, rows);
+  bitgeno_check(pMat, incols, false);
+
+  return LDPruneByChrom([&](BitGeno &g, const vector<size_t> &r) -> bool {
+    bitgeno_fill<T>(g, pMat, r, units, incols, false);
+    return true;
+  }, groups, winSNP, step, r2Thres, threads, verbose);
+}
+
+// [[Rcpp::export]]
+IntegerVector LDPrune(SEXP pBigMat, IntegerVector chrom, Nullable<IntegerVector> rowIdx=R_NilValue, Nullable<IntegerVector> colIdx=R_NilValue, int incols=1, int winSNP=50, int step=5, double r2Thres=0.2, int threads=0, bool verbose=true) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+
+  switch(xpMat->matrix_type()) {
+  case 1:
+    return LDPrune<char>(xpMat, chrom, rowIdx, colIdx, incols, winSNP, step, r2Thres, threads, verbose);
+  case 2:
+    return LDPrune<short>(xpMat, chrom, rowIdx, colIdx, incols, winSNP, step, r2Thres, threads, verbose);
+  case 4:
+    return LDPrune<int>(xpMat, chrom, rowIdx, colIdx, incols, winSNP, step, r2Thres, threads, verbose);
+  case 8:
+    return LDPrune<double>(xpMat, chrom, rowIdx, colIdx, incols, winSNP, step, r2Thres, threads, verbose);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
+
+// [[Rcpp::export]]
+IntegerVector LDPruneBed(std::string bed_file, int ind, IntegerVector chrom, Nullable<IntegerVector> rowIdx=R_NilValue, int winSNP=50, int step=5, double r2Thres=0.2, int threads=0, bool verbose=true) {
+  if (!boost::ends_with(bed_file, ".bed")) {
+    bed_file += ".bed";
+  }
+  vector<size_t> rows = LDRows(rowIdx, chrom.size());
+  vector< vector<size_t> > groups = LDGroupByChrom(chrom, rows);
+  bitgeno_check_bed(bed_file, ind, chrom.size());
+
+  return LDPruneByChrom([&](BitGeno &g, const vector<size_t> &r) -> bool {
+    return bitgeno_read_bed(g, bed_file, ind, r);
+  }, groups, winSNP, step, r2Thres, threads, verbose);
+}
+
+template <typename T>
+List LDClump(XPtr<BigMatrix> pMat, IntegerVector chrom, NumericVector pos, NumericVector pval, int incols=1, double p1=1e-4, double p2=0.01, double r2Thres=0.5, double winBP=250000, int threads=0, bool verbose=true) {
+  size_t m = pMat->nrow();
+  if (chrom.size() != (int)m || pos.size() != (int)m || pval.size() != (int)m) {
+    Rcpp::stop("'chrom', 'pos' and 'pval' should have the same length as marker number!");
+  }
+  vector<size_t> rows = LDRows(R_NilValue, m);
+  vector< vector<size_t> > groups = LDGroupByChrom(chrom, rows);
+  bitgeno_check(pMat, incols, false);
+
+  return LDClumpByChrom([&](BitGeno &g, const vector<size_t> &r) -> bool {
+    bitgeno_fill<T>(g, pMat, r, vector<size_t>(), incols, false);
+    return true;
+  }, groups, pos, pval, p1, p2, r2Thres, winBP, threads, verbose);
+}
+
+// [[Rcpp::export]]
+List LDClump(SEXP pBigMat, IntegerVector chrom, NumericVector pos, NumericVector pval, int incols=1, double p1=1e-4, double p2=0.01, double r2Thres=0.5, double winBP=250000, int threads=0, bool verbose=true) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+
+  switch(xpMat->matrix_type()) {
+  case 1:
+    return LDClump<char>(xpMat, chrom, pos, pval, incols, p1, p2, r2Thres, winBP, threads, verbose);
+  case 2:
+    return LDClump<short>(xpMat, chrom, pos, pval, incols, p1, p2, r2Thres, winBP, threads, verbose);
+  case 4:
+    return LDClump<int>(xpMat, chrom, pos, pval, incols, p1, p2, r2Thres, winBP, threads, verbose);
+  case 8:
+    return LDClump<double>(xpMat, chrom, pos, pval, incols, p1, p2, r2Thres, winBP, threads, verbose);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
+
+// [[Rcpp::export]]
+List LDClumpBed(std::string bed_file, int ind, IntegerVector chrom, NumericVector pos, NumericVector pval, double p1=1e-4, double p2=0.01, double r2Thres=0.5, double winBP=250000, int threads=0, bool verbose=true) {
+  if (!boost::ends_with(bed_file, ".bed")) {
+    bed_file += ".bed";
+  }
+  size_t m = chrom.size();
+  if (pos.size() != (int)m || pval.size() != (int)m) {
+    Rcpp::stop("'chrom', 'pos' and 'pval' should have the same length!");
+  }
+  vector<size_t> rows = LDRows(R_NilValue, m);
+  vector< vector<size_t> > groups = LDGroupByChrom(chrom, rows);
+  bitgeno_check_bed(bed_file, ind, chrom.size());
+
+  return LDClumpByChrom([&](BitGeno &g, const vector<size_t> &r) -> bool {
+    return bitgeno_read_bed(g, bed_file, ind, r);
+  }, groups, pos, pval, p1, p2, r2Thres, winBP, threads, verbose);
+}
@@ -0,0 +1,107 @@
+#include <RcppArmadillo.h>
+#include <bigmemory/BigMatrix.h>
+#include <bigmemory/MatrixAccessor.hpp>
+#include "simer_omp.h"
+#include "packed.h"
+
+// [[Rcpp::plugins(cpp11)]]
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::depends(bigmemory, BH)]]
+using namespace std;
+using namespace Rcpp;
+
+// [[Rcpp::export]]
+double PackedDim(std::string kin_file) {
+  return PackedSym::dim(kin_file);
+}
+
+// rows (1-based) of a packed symmetric matrix as a length(rows) x n matrix
+// [[Rcpp::export]]
+NumericMatrix PackedRows(std::string kin_file, IntegerVector rows, int threads=0) {
+  omp_setup(threads);
+
+  PackedSym pk;
+  pk.open(kin_file);
+  size_t n = pk.n, nr = rows.size();
+  for (size_t r = 0; r < nr; r++) {
+    if (rows[r] < 1 || (size_t)rows[r] > n) { Rcpp::stop("'rows' is out of range!"); }
+  }
+
+  NumericMatrix res(nr, n);
+  #pragma omp parallel
+  {
+    vector<double> buf(n);
+    #pragma omp for schedule(dynamic)
+    for (size_t r = 0; r < nr; r++) {
+      pk.row(rows[r] - 1, buf.data());
+      for (size_t j = 0; j < n; j++) { res(r, j) = buf[j]; }
+    }
+  }
+  return res;
+}
+
+// elements (i[k], j[k]), 1-based
+// [[Rcpp::export]]
+NumericVector PackedPairs(std::string kin_file, IntegerVector i, IntegerVector j) {
+  if (i.size() != j.size()) {
+    Rcpp::stop("'i' and 'j' should have the same length!");
+  }
+  PackedSym pk;
+  pk.open(kin_file);
+  NumericVector res(i.size());
+  for (int k = 0; k < i.size(); k++) {
+    if (i[k] < 1 || j[k] < 1 || (size_t)i[k] > pk.n || (size_t)j[k] > pk.n) {
+      Rcpp::stop("'i' or 'j' is out of range!");
+    }
+    res[k] = pk.get(i[k] - 1, j[k] - 1);
+  }
+  return res;
+}
+
+// upper triangle of a n x n double big.matrix into a packed file
+// [[Rcpp::export]]
+void PackedFromBig(SEXP pBigMat, std::string kin_file, int threads=0) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+  omp_setup(threads);
+
+  if (xpMat->matrix_type() != 8) {
+    Rcpp::stop("the big.matrix should be of type 'double'!");
+  }
+  size_t n = xpMat->ncol();
+  if ((size_t)xpMat->nrow() != n) {
+    Rcpp::stop("the big.matrix should be square!");
+  }
+  MatrixAccessor<double> bigm = MatrixAccessor<double>(*xpMat);
+  PackedSym::create(kin_file, n);
+  PackedSym pk;
+  pk.open(kin_file, true);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t j = 0; j < n; j++) {
+    double *col = bigm[j];
+    float *pcol = pk.data + PackedSym::index(0, j);
+    for (size_t i = 0; i <= j; i++) { pcol[i] = col[i]; }
+  }
+  pk.flush();
+}
+
+// a packed file into a n x n double big.matrix
+// [[Rcpp::export]]
+void PackedToBig(std::string kin_file, SEXP pBigMat, int threads=0) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+  omp_setup(threads);
+
+  PackedSym pk;
+  pk.open(kin_file);
+  size_t n = pk.n;
+  if (xpMat->matrix_type() != 8 || (size_t)xpMat->nrow() != n || (size_t)xpMat->ncol() != n) {
+    Rcpp::stop("the big.matrix should be n x n of type 'double'!");
+  }
+  MatrixAccessor<double> bigm = MatrixAccessor<double>(*xpMat);
+
+  // column j of a symmetric matrix is its row j
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t j = 0; j < n; j++) {
+    pk.row(j, bigm[j]);
+  }
+}
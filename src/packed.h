@@ -0,0 +1,147 @@
+#ifndef SIMER_PACKED_H_
+#define SIMER_PACKED_H_
+
+#include <Rcpp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+// [[Rcpp::plugins(cpp11)]]
+
+// 64-bit offsets for files larger than 2 GB
+static inline int simer_fseek(FILE *f, int64_t off) {
+#ifdef _WIN32
+  return _fseeki64(f, off, SEEK_SET);
+#else
+  return fseeko(f, (off_t)off, SEEK_SET);
+#endif
+}
+
+// FNV-1a hash of 'bytes' bytes, continued from 'h' so that several pieces
+// make one hash; it fingerprints the data of the cached files
+static inline uint64_t fnv1a(const void *p, size_t bytes, uint64_t h=14695981039346656037ULL) {
+  const unsigned char *b = static_cast<const unsigned char*>(p);
+  for (size_t i = 0; i < bytes; i++) {
+    h ^= b[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+// Symmetric matrix packed as its upper triangle in float32, in memory or
+// memory-mapped from a file of the layout
+//   bytes 0 - 7   : magic "SIMERPK2"
+//   bytes 8 - 15  : n, uint64
+//   bytes 16 - 23 : number of markers the matrix is of, uint64, 0 if unknown
+//   bytes 24 - 31 : fingerprint of the genotype, uint64, 0 if unknown
+//   then n(n + 1) / 2 floats, column by column, (i, j) with i <= j being
+//   at j(j + 1) / 2 + i.
+// A new column only appends to the file, so that the matrix can grow
+// without moving the stored elements.
+#define SIMER_PACKED_MAGIC "SIMERPK2"
+#define SIMER_PACKED_HEADER 32
+
+struct PackedSym {
+  size_t n;
+  float *data;
+  std::vector<float> mem;
+  boost::interprocess::file_mapping fm;
+  boost::interprocess::mapped_region region;
+
+  PackedSym() : n(0), data(NULL) {}
+
+  static size_t len(size_t n) { return n * (n + 1) / 2; }
+
+  static size_t index(size_t i, size_t j) {
+    if (i > j) { std::swap(i, j); }
+    return j * (j + 1) / 2 + i;
+  }
+
+  float get(size_t i, size_t j) const { return data[index(i, j)]; }
+  void set(size_t i, size_t j, float v) { data[index(i, j)] = v; }
+
+  // row i of the full matrix: column i above the diagonal is contiguous,
+  // the rest is read with a stride growing by one
+  template <typename V>
+  void row(size_t i, V *out) const {
+    const float *col = data + i * (i + 1) / 2;
+    for (size_t j = 0; j <= i; j++) { out[j] = col[j]; }
+    size_t k = index(i, i);
+    for (size_t j = i + 1; j < n; j++) {
+      k += j;
+      out[j] = data[k];
+    }
+  }
+
+  // in memory
+  void init(size_t n0) {
+    n = n0;
+    mem.assign(len(n), 0);
+    data = mem.data();
+  }
+
+  // Create (or grow) a file of dimension n0; the stored elements of a
+  // smaller matrix are kept, the new ones are 0.
+  static void create(std::string file, size_t n0, bool keep=false, uint64_t m=0, uint64_t key=0) {
+    FILE *f = fopen(file.c_str(), keep ? "r+b" : "wb");
+    if (f == NULL) {
+      Rcpp::stop("cannot open file: %s", file.c_str());
+    }
+    uint64_t hd[3] = {n0, m, key};
+    float zero = 0;
+    bool ok = fwrite(SIMER_PACKED_MAGIC, 1, 8, f) == 8 && fwrite(hd, 8, 3, f) == 3;
+    if (ok && len(n0) > 0) {
+      ok = simer_fseek(f, SIMER_PACKED_HEADER + (int64_t)(len(n0) - 1) * 4) == 0 && fwrite(&zero, 4, 1, f) == 1;
+    }
+    fclose(f);
+    if (!ok) {
+      Rcpp::stop("cannot write file: %s", file.c_str());
+    }
+  }
+
+  // dimension, number of markers, and fingerprint stored in the header of
+  // a file; false if it is not a packed file
+  static bool header(std::string file, uint64_t *hd) {
+    FILE *f = fopen(file.c_str(), "rb");
+    if (f == NULL) {
+      Rcpp::stop("cannot open file: %s", file.c_str());
+    }
+    char magic[8];
+    bool ok = fread(magic, 1, 8, f) == 8 && memcmp(magic, SIMER_PACKED_MAGIC, 8) == 0 && fread(hd, 8, 3, f) == 3;
+    fclose(f);
+    return ok;
+  }
+
+  // dimension stored in the header of a file
+  static size_t dim(std::string file) {
+    uint64_t hd[3];
+    if (!header(file, hd)) {
+      Rcpp::stop("not a packed symmetric matrix file: %s", file.c_str());
+    }
+    return hd[0];
+  }
+
+  // memory-map a file
+  void open(std::string file, bool write=false) {
+    using namespace boost::interprocess;
+    n = dim(file);
+    boost::interprocess::mode_t mode = write ? read_write : read_only;
+    file_mapping f(file.c_str(), mode);
+    mapped_region r(f, mode);
+    if (r.get_size() < SIMER_PACKED_HEADER + len(n) * 4) {
+      Rcpp::stop("the packed file is shorter than expected: %s", file.c_str());
+    }
+    fm.swap(f);
+    region.swap(r);
+    data = reinterpret_cast<float*>(static_cast<char*>(region.get_address()) + SIMER_PACKED_HEADER);
+  }
+
+  void flush() {
+    if (region.get_size() > 0) { region.flush(); }
+  }
+};
+
+#endif
@@ -1,8 +1,11 @@
 #include <RcppArmadillo.h>
+#include <unordered_map>
 #include <boost/algorithm/string.hpp>
 #include <bigmemory/BigMatrix.h>
 #include <bigmemory/MatrixAccessor.hpp>
 #include "simer_omp.h"
+#include "packed.h"
+#include "bitpack.h"
 #include "MinimalProgressBar.h"
 
 // [[Rcpp::plugins(cpp11)]]
@@ -12,218 +15,468 @@ using namespace std;
 using namespace Rcpp;
 using namespace arma;
 
+// Mendel conflicts (opposite homozygotes) of pairs of individuals. Every
+// individual is packed into two bit planes over the markers (dosage 0 and
+// dosage 2), so that a pair costs
+//   popcount((hom0_i & hom2_j) | (hom2_i & hom0_j))
+// over 64-marker words. Only the individuals taking part in a pair need to
+// be packed, 'slot' giving the planes of every genotyped individual.
+struct ConfPlanes {
+  size_t nw;
+  vector<long> slot;
+  vector<uint64_t> hom0, hom2;
+
+  // conflicts of the genotyped individuals i and j; the count is given up as
+  // soon as it passes 'limit', limit + 1 being returned then
+  size_t count(size_t i, size_t j, size_t limit=SIZE_MAX) const {
+    const uint64_t *a0 = &hom0[slot[i] * nw], *a2 = &hom2[slot[i] * nw];
+    const uint64_t *b0 = &hom0[slot[j] * nw], *b2 = &hom2[slot[j] * nw];
+    size_t c = 0;
+    for (size_t w = 0; w < nw; w++) {
+      c += popcnt64((a0[w] & b2[w]) | (a2[w] & b0[w]));
+      if ((w & 15) == 15 && c > limit) { return limit + 1; }
+    }
+    return c > limit ? limit + 1 : c;
+  }
+
+  // FNV-1a hash of the planes, by which conflicts saved in a file are
+  // matched to the genotype
+  uint64_t key() const {
+    return fnv1a(hom2.data(), hom2.size() * 8, fnv1a(hom0.data(), hom0.size() * 8));
+  }
+};
+
+// planes of the individuals 'cols', all if empty
 template<typename T>
-arma::mat calConf(XPtr<BigMatrix> pMat, int threads=0, bool verbose=true) {
+void confPlanes(XPtr<BigMatrix> pMat, ConfPlanes &P, vector<size_t> cols, int threads=0) {
   omp_setup(threads);
-  
-  if (verbose) { Rcout << " Computing Mendel Conflict Matrix..." << endl; }
-  
+
   MatrixAccessor<T> bigm = MatrixAccessor<T>(*pMat);
   size_t m = pMat->nrow();
   size_t n = pMat->ncol();
-  size_t i, j, k;
+  if (cols.empty()) {
+    for (size_t i = 0; i < n; i++) { cols.push_back(i); }
+  }
+  P.nw = (m + 63) / 64;
+  P.slot.assign(n, -1);
+  for (size_t s = 0; s < cols.size(); s++) { P.slot[cols[s]] = s; }
+  P.hom0.assign(cols.size() * P.nw, 0);
+  P.hom2.assign(cols.size() * P.nw, 0);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t s = 0; s < cols.size(); s++) {
+    T *col = bigm[cols[s]];
+    uint64_t *h0 = &P.hom0[s * P.nw], *h2 = &P.hom2[s * P.nw];
+    for (size_t k = 0; k < m; k++) {
+      if (col[k] == 0) {
+        h0[k >> 6] |= (uint64_t)1 << (k & 63);
+      } else if (col[k] == 2) {
+        h2[k >> 6] |= (uint64_t)1 << (k & 63);
+      }
+    }
+  }
+}
+
+// Sketch of the planes on a few hundred informative markers, those of the
+// highest rate of opposite homozygotes between two random individuals
+// (2 * f0 * f2). A pair of more sketch conflicts than a true parent of the
+// assignment rate 'thres' would show (mean + 4 sd of the binomial) is
+// rejected before the full-panel count.
+struct ConfSketch {
+  size_t nw, limit;
+  vector<uint64_t> hom0, hom2;
+
+  ConfSketch() : nw(0), limit(0) {}
+
+  size_t count(const ConfPlanes &P, size_t i, size_t j) const {
+    const uint64_t *a0 = &hom0[P.slot[i] * nw], *a2 = &hom2[P.slot[i] * nw];
+    const uint64_t *b0 = &hom0[P.slot[j] * nw], *b2 = &hom2[P.slot[j] * nw];
+    size_t c = 0;
+    for (size_t w = 0; w < nw; w++) { c += popcnt64((a0[w] & b2[w]) | (a2[w] & b0[w])); }
+    return c;
+  }
+};
+
+void confSketch(const ConfPlanes &P, ConfSketch &K, size_t size, double thres, int threads=0) {
+  omp_setup(threads);
+
+  size_t nslot = P.hom0.size() / max(P.nw, (size_t)1), m = P.nw * 64;
+  if (size == 0 || nslot == 0 || size >= m) { return; }
+
+  // homozygote counts of every marker
+  vector<double> f0(m, 0), f2(m, 0);
+  #pragma omp parallel
+  {
+    vector<double> c0(m, 0), c2(m, 0);
+    #pragma omp for schedule(dynamic)
+    for (size_t s = 0; s < nslot; s++) {
+      for (size_t w = 0; w < P.nw; w++) {
+        for (uint64_t x = P.hom0[s * P.nw + w]; x; x &= x - 1) { c0[w * 64 + ctz64(x)]++; }
+        for (uint64_t x = P.hom2[s * P.nw + w]; x; x &= x - 1) { c2[w * 64 + ctz64(x)]++; }
+      }
+    }
+    #pragma omp critical
+    for (size_t k = 0; k < m; k++) { f0[k] += c0[k]; f2[k] += c2[k]; }
+  }
+  vector<size_t> mk(m);
+  for (size_t k = 0; k < m; k++) { mk[k] = k; }
+  partial_sort(mk.begin(), mk.begin() + size, mk.end(), [&](size_t x, size_t y) { return f0[x] * f2[x] > f0[y] * f2[y]; });
+  mk.resize(size);
+  sort(mk.begin(), mk.end());
+
+  K.nw = (size + 63) / 64;
+  K.limit = ceil(size * thres + 4 * sqrt(size * thres * (1 - thres)));
+  K.hom0.assign(nslot * K.nw, 0);
+  K.hom2.assign(nslot * K.nw, 0);
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t s = 0; s < nslot; s++) {
+    for (size_t t = 0; t < size; t++) {
+      size_t k = mk[t];
+      uint64_t bit = (uint64_t)1 << (t & 63);
+      if ((P.hom0[s * P.nw + (k >> 6)] >> (k & 63)) & 1) { K.hom0[s * K.nw + (t >> 6)] |= bit; }
+      if ((P.hom2[s * P.nw + (k >> 6)] >> (k & 63)) & 1) { K.hom2[s * K.nw + (t >> 6)] |= bit; }
+    }
+  }
+}
+
+// The triangle of all pairs is cut into tiles of individuals and the tile
+// pairs are handed out to the threads, which keeps the threads evenly loaded
+// and the planes of both tiles in cache.
+#define SIMER_CONF_TILE 64
+
+static vector< pair<size_t, size_t> > confTiles(size_t n) {
+  size_t ntile = (n + SIMER_CONF_TILE - 1) / SIMER_CONF_TILE;
+  vector< pair<size_t, size_t> > tiles;
+  for (size_t tj = 0; tj < ntile; tj++) {
+    for (size_t ti = 0; ti <= tj; ti++) { tiles.push_back(make_pair(ti, tj)); }
+  }
+  return tiles;
+}
+
+// all pairs, kept as the upper triangle in float32, which is exact up to
+// 2^24 markers
+void calConf(const ConfPlanes &P, PackedSym &numConfs, int threads=0, bool verbose=true) {
+  omp_setup(threads);
   
-  arma::mat numConfs(n, n, fill::zeros);
-  arma::vec coli(m), colj(m);
+  if (verbose) { Rcout << " Computing Mendel Conflict Matrix..." << endl; }
+  
+  size_t n = P.slot.size();
+  vector< pair<size_t, size_t> > tiles = confTiles(n);
   
   MinimalProgressBar pb;
-  Progress p(n, verbose, pb);
+  Progress p(tiles.size(), verbose, pb);
   
-  #pragma omp parallel for schedule(dynamic) firstprivate(coli, colj) private(i, j, k)
-  for (i = 0; i < n; i++) {
-    for(k = 0; k < m; k++){
-      coli[k] = bigm[i][k];
-    }
-    coli.elem(find(coli == 1)).fill(3);
-    for (j = i+1; j < n; j++) {
-      for (k = 0; k < m; k++) {
-        colj[k] = bigm[j][k];
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t t = 0; t < tiles.size(); t++) {
+    size_t i0 = tiles[t].first * SIMER_CONF_TILE, i1 = min(n, i0 + SIMER_CONF_TILE);
+    size_t j0 = tiles[t].second * SIMER_CONF_TILE, j1 = min(n, j0 + SIMER_CONF_TILE);
+    for (size_t j = j0; j < j1; j++) {
+      for (size_t i = i0; i < min(i1, j); i++) {
+        numConfs.set(i, j, P.count(i, j));
       }
-      arma::uvec confIdx = arma::find(coli == 2 - colj);
-      numConfs(i, j) = confIdx.size();
-      numConfs(j, i) = confIdx.size();
     }
     if ( ! Progress::check_abort() ) { p.increment(); }
   }
-  
-  return numConfs;
 }
 
-arma::mat calConf(XPtr<BigMatrix> pMat, int threads=0, bool verbose=true) {
-  XPtr<BigMatrix> xpMat(pMat);
+// Pairs of a kid and a candidate parent of at most 'limit' conflicts only,
+// every kid keeping its plausible parents sorted by index, so that the
+// memory follows the number of relatives instead of n^2, and a pair is given
+// up as soon as its count passes the limit. Only the rectangular blocks of
+// kids by candidates are visited, and a candidate born after the kid
+// ('born', NaN if unknown) is skipped before any genotype work.
+struct ConfSparse {
+  vector< vector< pair<uint32_t, float> > > rows;
+};
+
+void calConf(const ConfPlanes &P, ConfSparse &S, const vector<size_t> &kids, const vector<size_t> &cands, const vector<double> &born, size_t limit, const ConfSketch &K, int threads=0, bool verbose=true) {
+  omp_setup(threads);
   
-  switch(xpMat->matrix_type()) {
-  case 1:
-    return calConf<char>(xpMat, threads, verbose);
-  case 2:
-    return calConf<short>(xpMat, threads, verbose);
-  case 4:
-    return calConf<int>(xpMat, threads, verbose);
-  case 8:
-    return calConf<double>(xpMat, threads, verbose);
-  default:
-    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  if (verbose) { Rcout << " Computing Mendel Conflicts of " << kids.size() << " kids and " << cands.size() << " candidate parents..." << endl; }
+  
+  size_t nk = kids.size(), nc = cands.size();
+  size_t tk = (nk + SIMER_CONF_TILE - 1) / SIMER_CONF_TILE, tc = (nc + SIMER_CONF_TILE - 1) / SIMER_CONF_TILE;
+  S.rows.assign(P.slot.size(), vector< pair<uint32_t, float> >());
+  
+  MinimalProgressBar pb;
+  Progress p(tk * tc, verbose, pb);
+  
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t t = 0; t < tk * tc; t++) {
+    size_t k0 = (t / tc) * SIMER_CONF_TILE, k1 = min(nk, k0 + SIMER_CONF_TILE);
+    size_t c0 = (t % tc) * SIMER_CONF_TILE, c1 = min(nc, c0 + SIMER_CONF_TILE);
+    for (size_t k = k0; k < k1; k++) {
+      size_t kid = kids[k];
+      vector< pair<uint32_t, float> > rel;
+      for (size_t c = c0; c < c1; c++) {
+        size_t cand = cands[c];
+        if (born[cand] > born[kid]) { continue; }
+        if (K.nw > 0 && K.count(P, kid, cand) > K.limit) { continue; }
+        size_t conf = P.count(kid, cand, limit);
+        if (conf <= limit) { rel.push_back(make_pair(cand, conf)); }
+      }
+      if (rel.empty()) { continue; }
+      // a kid is shared by the tiles of all candidates
+      #pragma omp critical
+      S.rows[kid].insert(S.rows[kid].end(), rel.begin(), rel.end());
+    }
+    if ( ! Progress::check_abort() ) { p.increment(); }
+  }
+  
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t k = 0; k < nk; k++) {
+    sort(S.rows[kids[k]].begin(), S.rows[kids[k]].end());
   }
 }
 
+// states of a recorded parent
+enum ParState { PAR_NONE, PAR_NOGENO, PAR_NOTFOUND, PAR_MATCH, PAR_FOUND };
+static const char *parStateName[] = {"", "NoGeno", "NotFound", "Match", "Found"};
+
 template <typename T>
-DataFrame PedigreeCorrector(XPtr<BigMatrix> pMat, StringVector genoID, DataFrame rawPed, Nullable<StringVector> candSirID=R_NilValue, Nullable<StringVector> candDamID=R_NilValue, double exclThres=0.005, double assignThres=0.01, Nullable<NumericVector> birthDate=R_NilValue, int threads=0, bool verbose=true) {
+DataFrame PedigreeCorrector(XPtr<BigMatrix> pMat, StringVector genoID, DataFrame rawPed, Nullable<StringVector> candSirID=R_NilValue, Nullable<StringVector> candDamID=R_NilValue, double exclThres=0.005, double assignThres=0.01, Nullable<NumericVector> birthDate=R_NilValue, int threads=0, bool verbose=true, std::string confFile="", int sketchSize=0) {
   omp_setup(threads);
   
   // ******* 01 prepare data for checking rawPed *******
   StringVector kidID = rawPed[0], sirOriID = rawPed[1], damOriID = rawPed[2], sirID = rawPed[3], damID = rawPed[4];
-  size_t n = kidID.size(), m = pMat->nrow();
-  LogicalVector kidEqSir = (kidID == sirID);
-  LogicalVector kidEqDam = (kidID == damID);
-
-  StringVector fullSirID, fullDamID;
-  copy(sirID.begin(), sirID.end(), back_inserter(fullSirID));
-  copy(damID.begin(), damID.end(), back_inserter(fullDamID));
-
-  StringVector candSir, candDam;
+  size_t n = kidID.size(), m = pMat->nrow(), nGeno = pMat->ncol();
+  
+  // IDs are interned as genotype positions, -1 if not genotyped
+  unordered_map<string, long> genoIndex;
+  for (size_t g = 0; g < nGeno; g++) { genoIndex.insert(make_pair(as<string>(genoID[g]), (long)g)); }
+  auto intern = [&](const string &id) -> long {
+    unordered_map<string, long>::const_iterator it = genoIndex.find(id);
+    return it == genoIndex.end() ? -1 : it->second;
+  };
+  
+  // genotyped sires and dams a kid can be assigned to
+  vector<unsigned char> isSir(nGeno, 0), isDam(nGeno, 0);
+  vector<string> kidStr(n), sirStr(n), damStr(n);
+  for (size_t i = 0; i < n; i++) {
+    kidStr[i] = as<string>(kidID[i]); sirStr[i] = as<string>(sirID[i]); damStr[i] = as<string>(damID[i]);
+    long g;
+    if (sirStr[i] != "0" && (g = intern(sirStr[i])) >= 0) { isSir[g] = 1; }
+    if (damStr[i] != "0" && (g = intern(damStr[i])) >= 0) { isDam[g] = 1; }
+  }
   if (candSirID.isNotNull()) {
     StringVector candSirIDUse = as<StringVector>(candSirID);
-    for (size_t i = 0; i < candSirIDUse.size(); i++)
-      fullSirID.insert(fullSirID.end(), candSirIDUse[i]);
+    for (int k = 0; k < candSirIDUse.size(); k++) {
+      long g = intern(as<string>(candSirIDUse[k]));
+      if (g >= 0) { isSir[g] = 1; }
+    }
   }
   if (candDamID.isNotNull()) {
     StringVector candDamIDUse = as<StringVector>(candDamID);
-    for (size_t i = 0; i < candDamIDUse.size(); i++)
-      fullSirID.insert(fullSirID.end(), candDamIDUse[i]);
+    for (int k = 0; k < candDamIDUse.size(); k++) {
+      long g = intern(as<string>(candDamIDUse[k]));
+      if (g >= 0) { isDam[g] = 1; }
+    }
   }
   NumericVector birdate;
-  if (birthDate.isNotNull()) {
+  bool hasBirth = birthDate.isNotNull();
+  if (hasBirth) {
     birdate = as<NumericVector>(birthDate);
   }
-  fullSirID = sort_unique(fullSirID); fullSirID.erase(0);
-  fullDamID = sort_unique(fullDamID); fullDamID.erase(0);
   
   // kids should not be same as parents
-  sirID[kidEqSir] = "0"; damID[kidEqDam] = "0";
-  NumericVector kidOrder, sirOrder, damOrder;
-  kidOrder = match(kidID, genoID); kidOrder = kidOrder - 1;
-  sirOrder = match(sirID, genoID); sirOrder = sirOrder - 1;
-  damOrder = match(damID, genoID); damOrder = damOrder - 1;
-  LogicalVector naKid, naSir, naDam;
-  naKid = is_na(kidOrder); naSir = is_na(sirOrder); naDam = is_na(damOrder);
-  StringVector sirState(n), damState(n);
+  vector<long> kidIdx(n), sirIdx(n), damIdx(n);
+  vector<ParState> sirState(n, PAR_NONE), damState(n, PAR_NONE);
   NumericVector sirNumConfs(n), damNumConfs(n);
+  for (size_t i = 0; i < n; i++) {
+    kidIdx[i] = intern(kidStr[i]);
+    bool kidEqSir = kidStr[i] == sirStr[i], kidEqDam = kidStr[i] == damStr[i];
+    sirIdx[i] = kidEqSir ? intern("0") : intern(sirStr[i]);
+    damIdx[i] = kidEqDam ? intern("0") : intern(damStr[i]);
+    if (kidIdx[i] < 0 || sirIdx[i] < 0) { sirState[i] = PAR_NOGENO; }
+    if (kidIdx[i] < 0 || damIdx[i] < 0) { damState[i] = PAR_NOGENO; }
+    if (kidEqSir) { sirState[i] = PAR_NOTFOUND; }
+    if (kidEqDam) { damState[i] = PAR_NOTFOUND; }
+  }
   
   int exclMax = exclThres * m, assignMax = assignThres * m;
   
   // ******* 02 check rawPed *******
-  sirState[naKid | naSir] = "NoGeno"; sirState[kidEqSir] = "NotFound"; 
-  damState[naKid | naDam] = "NoGeno"; damState[kidEqDam] = "NotFound"; 
+  // calculate conflict of pedigree in the rawPed, or read it from the
+  // packed file of a former run on the same genotype, matched by the
+  // number of markers and the hash of the planes; without a file, only
+  // the pairs of a kid and a candidate parent under 'assignMax' are kept,
+  // as a found pair should be of a candidate sire and a candidate dam
+  bool dense = !confFile.empty();
+  PackedSym numConfs;
+  ConfSparse sparseConfs;
+  ConfPlanes planes;
+  FILE *fconf = confFile.empty() ? NULL : fopen(confFile.c_str(), "rb");
+  if (fconf != NULL) { fclose(fconf); }
+  
+  // the latest birth date of every genotyped kid
+  vector<double> born(nGeno, NAN);
+  if (hasBirth) {
+    for (size_t i = 0; i < n; i++) {
+      if (kidIdx[i] >= 0 && !(born[kidIdx[i]] >= birdate[i])) { born[kidIdx[i]] = birdate[i]; }
+    }
+  }
   
-  // calculate conflict of pedigree in the rawPed
-  arma::mat numConfs = calConf(pMat, threads, verbose);
-  // arma::mat numConfs(pMat->ncol(), pMat->ncol(), fill::zeros);
+  if (dense) {
+    confPlanes<T>(pMat, planes, vector<size_t>(), threads);
+    uint64_t key = planes.key(), hd[3];
+    if (fconf != NULL && PackedSym::header(confFile, hd) && hd[0] == nGeno && hd[1] == m && hd[2] == key) {
+      if (verbose) { Rcout << " Reading Mendel Conflict Matrix from " << confFile << "..." << endl; }
+      numConfs.open(confFile);
+    } else {
+      if (verbose && fconf != NULL) { Rcout << " " << confFile << " is not of the genotype, recalculating..." << endl; }
+      PackedSym::create(confFile, nGeno, false, m, key);
+      numConfs.open(confFile, true);
+      calConf(planes, numConfs, threads, verbose);
+      numConfs.flush();
+    }
+  } else {
+    vector<unsigned char> isKid(nGeno, 0), isCand(nGeno, 0);
+    for (size_t i = 0; i < n; i++) {
+      if (kidIdx[i] < 0) { continue; }
+      isKid[kidIdx[i]] = 1;
+      if (sirIdx[i] >= 0) { isCand[sirIdx[i]] = 1; }
+      if (damIdx[i] >= 0) { isCand[damIdx[i]] = 1; }
+    }
+    vector<size_t> kids, cands, cols;
+    for (size_t g = 0; g < nGeno; g++) {
+      if (isSir[g] || isDam[g]) { isCand[g] = 1; }
+      if (isKid[g]) { kids.push_back(g); }
+      if (isCand[g]) { cands.push_back(g); }
+      if (isKid[g] || isCand[g]) { cols.push_back(g); }
+    }
+    confPlanes<T>(pMat, planes, cols, threads);
+    if (assignMax > 0) {
+      ConfSketch sketch;
+      confSketch(planes, sketch, sketchSize, assignThres, threads);
+      calConf(planes, sparseConfs, kids, cands, born, assignMax - 1, sketch, threads, verbose);
+    }
+  }
+  auto getConf = [&](size_t i, size_t j) -> double {
+    return dense ? numConfs.get(i, j) : planes.count(i, j);
+  };
   
+  #pragma omp parallel for schedule(dynamic)
   for (size_t i = 0; i < n; i++) {
 
-    if (naKid[i]) { continue; }
+    if (kidIdx[i] < 0) { continue; }
 
-    if (!naSir[i]) {
-      sirNumConfs[i] = numConfs(kidOrder[i], sirOrder[i]);
+    if (sirIdx[i] >= 0) {
+      sirNumConfs[i] = getConf(kidIdx[i], sirIdx[i]);
       if (sirNumConfs[i] <= exclMax) {
-        sirState[i] = "Match";
+        sirState[i] = PAR_MATCH;
       } else {
-        sirState[i] = "NotFound";
-        sirID[i] = "0";
+        sirState[i] = PAR_NOTFOUND;
+        sirIdx[i] = -1;
       }
     }
 
-    if (!naDam[i]) {
-      damNumConfs[i] = numConfs(kidOrder[i], damOrder[i]);
+    if (damIdx[i] >= 0) {
+      damNumConfs[i] = getConf(kidIdx[i], damIdx[i]);
       if (damNumConfs[i] <= exclMax) {
-        damState[i] = "Match";
+        damState[i] = PAR_MATCH;
       } else {
-        damState[i] = "NotFound";
-        damID[i] = "0";
+        damState[i] = PAR_NOTFOUND;
+        damIdx[i] = -1;
       }
     }
 
   }
 
   // ******* 03 seek parents of NotMatch in the rawPed *******
-  StringVector candKid(n);
-  LogicalVector kidFlag;
-  NumericVector candKidOrder, candParOrder;
-  arma::uvec candParUse;
-  size_t numCand;
-  arma::mat subNumConfs;
-
-  arma::uword maxPos, rowPos, colPos;
-  StringVector candPar1(1), candPar2(1);
-  
-  size_t i, j;
+  // genotyped offspring of every genotyped individual by the checked
+  // pedigree, which can not be its parents
+  vector< vector<long> > offspring(nGeno);
+  for (size_t i = 0; i < n; i++) {
+    if (kidIdx[i] < 0) { continue; }
+    if (sirIdx[i] >= 0) { offspring[sirIdx[i]].push_back(kidIdx[i]); }
+    if (damIdx[i] >= 0) { offspring[damIdx[i]].push_back(kidIdx[i]); }
+  }
+  for (size_t g = 0; g < nGeno; g++) { sort(offspring[g].begin(), offspring[g].end()); }
 
   MinimalProgressBar pb;
   Progress p(n, verbose, pb);
 
   if(verbose) { Rcout << " Seeking Parents..." << endl; }
-  // #pragma omp parallel for schedule(dynamic) private(i, j)
-  for (i = 0; i < n; i++) {
-
-    if ((sirState[i] != "NotFound") && (damState[i] != "NotFound")) { continue; }
-    
-    candKid.fill(kidID[i]);
-    kidFlag = (sirID == candKid | damID == candKid) & !naKid;
-    if (birthDate.isNotNull()) {  kidFlag = kidFlag |  birdate > birdate[i]; }
-    candKidOrder = kidOrder[kidFlag];
-    candParOrder = wrap(arma::find(numConfs.row(kidOrder[i]) < assignMax));
-    candParUse = as<arma::uvec>(setdiff(candParOrder, candKidOrder));
-    numCand = candParUse.size();
-    if (numCand == 0) { continue; }
-    subNumConfs = numConfs.rows(candParUse);
-    subNumConfs = subNumConfs.cols(candParUse);
-    
-    arma::uvec sortIdx = sort_index(subNumConfs);
-    for (j = 0; j < sortIdx.n_elem; j++) {
-      
-      maxPos = sortIdx[sortIdx.n_elem-1-j];;
-      rowPos = (maxPos + 1) % numCand;
-      colPos = (maxPos + 1) / numCand;
-      if (rowPos == 0) {
-        rowPos = numCand;
-        colPos = colPos - 1;
-      }
-      rowPos = rowPos - 1;
-      candPar1[0] = genoID[candParUse[rowPos]];
-      candPar2[0] = genoID[candParUse[colPos]];
-
-      if ((sirState[i] == "Match") || (sirState[i] == "Found")) {
-        if (candPar1[0] != sirID[i]) {
-          continue;
-        } 
+  #pragma omp parallel
+  {
+    vector<float> confRow(dense ? nGeno : 0);
+    vector<size_t> cand;
+    vector<double> sub;
+    vector<size_t> order;
+
+    #pragma omp for schedule(dynamic)
+    for (size_t i = 0; i < n; i++) {
+
+      if (kidIdx[i] < 0) { continue; }
+      if ((sirState[i] != PAR_NOTFOUND) && (damState[i] != PAR_NOTFOUND)) { continue; }
+
+      long kid = kidIdx[i];
+      const vector<long> &kids = offspring[kid];
+      auto usable = [&](size_t c) -> bool {
+        if (binary_search(kids.begin(), kids.end(), (long)c)) { return false; }
+        return !(hasBirth && born[c] > birdate[i]);
+      };
+      cand.clear();
+      if (dense) {
+        numConfs.row(kid, confRow.data());
+        for (size_t c = 0; c < nGeno; c++) {
+          if (confRow[c] < assignMax && usable(c)) { cand.push_back(c); }
+        }
+      } else if (!sparseConfs.rows.empty()) {
+        const vector< pair<uint32_t, float> > &rel = sparseConfs.rows[kid];
+        for (size_t r = 0; r < rel.size(); r++) {
+          if (usable(rel[r].first)) { cand.push_back(rel[r].first); }
+        }
       }
-      if ((damState[i] == "Match") || (damState[i] == "Found")) {
-        if (candPar2[0] != damID[i]) {
-          continue;
-        } 
+      size_t numCand = cand.size();
+      if (numCand == 0) { continue; }
+
+      // candidate pairs from the most conflicting, column-major
+      sub.resize(numCand * numCand);
+      for (size_t j = 0; j < numCand; j++) {
+        for (size_t r = 0; r < numCand; r++) {
+          sub[j * numCand + r] = getConf(cand[r], cand[j]);
+        }
       }
-      
-      if (find(fullSirID.begin(), fullSirID.end(), candPar1[0]) != fullSirID.end()) {
-        if (find(fullDamID.begin(), fullDamID.end(), candPar2[0]) != fullDamID.end()) {
-          if (sirState[i] == "NotFound") {
-            sirID[i] = candPar1[0];
-            sirState[i] = "Found";
-            sirNumConfs[i] = numConfs(kidOrder[i], candParUse[rowPos]);
+      order.resize(sub.size());
+      for (size_t k = 0; k < order.size(); k++) { order[k] = k; }
+      stable_sort(order.begin(), order.end(), [&](size_t x, size_t y) { return sub[x] < sub[y]; });
+
+      for (size_t k = order.size(); k-- > 0; ) {
+        size_t par1 = cand[order[k] % numCand], par2 = cand[order[k] / numCand];
+
+        if ((sirState[i] == PAR_MATCH || sirState[i] == PAR_FOUND) && (long)par1 != sirIdx[i]) { continue; }
+        if ((damState[i] == PAR_MATCH || damState[i] == PAR_FOUND) && (long)par2 != damIdx[i]) { continue; }
+
+        if (isSir[par1] && isDam[par2]) {
+          if (sirState[i] == PAR_NOTFOUND) {
+            sirIdx[i] = par1;
+            sirState[i] = PAR_FOUND;
+            sirNumConfs[i] = getConf(kid, par1);
           }
-          if (damState[i] == "NotFound") {
-            damID[i] = candPar2[0];
-            damState[i] = "Found";
-            damNumConfs[i] = numConfs(kidOrder[i], candParUse[colPos]);
+          if (damState[i] == PAR_NOTFOUND) {
+            damIdx[i] = par2;
+            damState[i] = PAR_FOUND;
+            damNumConfs[i] = getConf(kid, par2);
           }
-          if (((sirState[i] == "Match") || (sirState[i] == "Found")) && ((damState[i] == "Match") || (damState[i] == "Found"))) {
+          if ((sirState[i] == PAR_MATCH || sirState[i] == PAR_FOUND) && (damState[i] == PAR_MATCH || damState[i] == PAR_FOUND)) {
             break;
           }
         }
       }
-      
-    }
 
-    if ( ! Progress::check_abort() ) { p.increment(); }
+      if ( ! Progress::check_abort() ) { p.increment(); }
+    }
+  }
+  
+  StringVector sirState2(n), damState2(n);
+  for (size_t i = 0; i < n; i++) {
+    if (sirState[i] == PAR_NOTFOUND) { sirID[i] = "0"; }
+    if (damState[i] == PAR_NOTFOUND) { damID[i] = "0"; }
+    if (sirState[i] == PAR_FOUND) { sirID[i] = genoID[sirIdx[i]]; }
+    if (damState[i] == PAR_FOUND) { damID[i] = genoID[damIdx[i]]; }
+    sirState2[i] = parStateName[sirState[i]];
+    damState2[i] = parStateName[damState[i]];
   }
   
   DataFrame parConflict = DataFrame::create(
@@ -232,8 +485,8 @@ DataFrame PedigreeCorrector(XPtr<BigMatrix> pMat, StringVector genoID, DataFrame
     _["damOrigin"]      = damOriID,
     _["sirFound"]       = sirID,
     _["damFound"]       = damID,
-    _["sirState"]       = sirState,
-    _["damState"]       = damState,
+    _["sirState"]       = sirState2,
+    _["damState"]       = damState2,
     _["sirNumConfs"]    = sirNumConfs,
     _["damNumConfs"]    = damNumConfs,
     _["sirRatioConfs"]  = sirNumConfs * 100 / m,
@@ -243,20 +496,305 @@ DataFrame PedigreeCorrector(XPtr<BigMatrix> pMat, StringVector genoID, DataFrame
 }
 
 // [[Rcpp::export]]
-DataFrame PedigreeCorrector(const SEXP pBigMat, StringVector rawGenoID, DataFrame rawPed, Nullable<StringVector> candSirID=R_NilValue, Nullable<StringVector> candDamID=R_NilValue, double exclThres=0.005, double assignThres=0.02, Nullable<NumericVector> birthDate=R_NilValue, int threads=0, bool verbose=true){
+DataFrame PedigreeCorrector(const SEXP pBigMat, StringVector rawGenoID, DataFrame rawPed, Nullable<StringVector> candSirID=R_NilValue, Nullable<StringVector> candDamID=R_NilValue, double exclThres=0.005, double assignThres=0.02, Nullable<NumericVector> birthDate=R_NilValue, int threads=0, bool verbose=true, std::string confFile="", int sketchSize=0){
   XPtr<BigMatrix> xpMat(pBigMat);
   
   switch(xpMat->matrix_type()) {
   case 1:
-    return PedigreeCorrector<char>(xpMat, rawGenoID, rawPed, candSirID, candDamID, exclThres, assignThres, birthDate, threads, verbose);
+    return PedigreeCorrector<char>(xpMat, rawGenoID, rawPed, candSirID, candDamID, exclThres, assignThres, birthDate, threads, verbose, confFile, sketchSize);
   case 2:
-    return PedigreeCorrector<short>(xpMat, rawGenoID, rawPed, candSirID, candDamID, exclThres, assignThres, birthDate, threads, verbose);
+    return PedigreeCorrector<short>(xpMat, rawGenoID, rawPed, candSirID, candDamID, exclThres, assignThres, birthDate, threads, verbose, confFile, sketchSize);
   case 4:
-    return PedigreeCorrector<int>(xpMat, rawGenoID, rawPed, candSirID, candDamID, exclThres, assignThres, birthDate, threads, verbose);
+    return PedigreeCorrector<int>(xpMat, rawGenoID, rawPed, candSirID, candDamID, exclThres, assignThres, birthDate, threads, verbose, confFile, sketchSize);
   case 8:
-    return PedigreeCorrector<double>(xpMat, rawGenoID, rawPed, candSirID, candDamID, exclThres, assignThres, birthDate, threads, verbose);
+    return PedigreeCorrector<double>(xpMat, rawGenoID, rawPed, candSirID, candDamID, exclThres, assignThres, birthDate, threads, verbose, confFile, sketchSize);
   default:
     throw Rcpp::exception("unknown type detected for big.matrix object!");
   }
 }
 
+
+// Pedigree records 'ped' of 3 columns (Ind Sir Dam) or of 15 columns giving
+// three generations (Ind Sir Dam SS SD DS DD SSS SSD SDS SDD DSS DSD DDS DDD)
+// as unique records of 3 columns: every generation of the 15 columns is
+// expanded to its own records, parents never recorded as individuals are put
+// ahead as founders, records of individual "0" are dropped and only the first
+// record of an individual is kept, the others being returned as 'dup'.
+// [[Rcpp::export]]
+List PedigreeExpand(CharacterMatrix ped) {
+  int n = ped.nrow();
+  vector<string> kid, sir, dam;
+  if (ped.ncol() == 3) {
+    for (int i = 0; i < n; i++) {
+      kid.push_back(as<string>(ped(i, 0)));
+      sir.push_back(as<string>(ped(i, 1)));
+      dam.push_back(as<string>(ped(i, 2)));
+    }
+  } else if (ped.ncol() == 15) {
+    // column of the individual and of its sire and dam, in the order of the
+    // generations
+    const int link[15][3] = {
+      {0, 1, 2}, {1, 3, 4}, {2, 5, 6}, {3, 7, 8}, {4, 9, 10}, {5, 11, 12}, {6, 13, 14},
+      {7, -1, -1}, {8, -1, -1}, {9, -1, -1}, {10, -1, -1}, {11, -1, -1}, {12, -1, -1}, {13, -1, -1}, {14, -1, -1}
+    };
+    for (int c = 0; c < 15; c++) {
+      for (int i = 0; i < n; i++) {
+        kid.push_back(as<string>(ped(i, link[c][0])));
+        sir.push_back(link[c][1] < 0 ? "0" : as<string>(ped(i, link[c][1])));
+        dam.push_back(link[c][2] < 0 ? "0" : as<string>(ped(i, link[c][2])));
+      }
+    }
+  } else {
+    Rcpp::stop("pedigree should have 3 or 15 columns!");
+  }
+
+  unordered_map<string, size_t> seen;
+  seen.reserve(2 * kid.size());
+  for (size_t i = 0; i < kid.size(); i++) { seen.emplace(kid[i], i); }
+
+  // parents missing as individuals, sires before dams
+  vector<string> founder;
+  const vector<string> *par[2] = {&sir, &dam};
+  for (int p = 0; p < 2; p++) {
+    for (size_t i = 0; i < par[p]->size(); i++) {
+      const string &id = (*par[p])[i];
+      if (id != "0" && seen.emplace(id, kid.size()).second) { founder.push_back(id); }
+    }
+  }
+
+  seen.clear();
+  vector<size_t> keep, dup;
+  size_t nf = founder.size();
+  for (size_t i = 0; i < nf + kid.size(); i++) {
+    const string &id = i < nf ? founder[i] : kid[i - nf];
+    if (id == "0") { continue; }
+    if (seen.emplace(id, i).second) {
+      keep.push_back(i);
+    } else {
+      dup.push_back(i);
+    }
+  }
+
+  const vector<size_t> *rows[2] = {&keep, &dup};
+  CharacterMatrix out[2];
+  for (int r = 0; r < 2; r++) {
+    out[r] = CharacterMatrix(rows[r]->size(), 3);
+    for (size_t k = 0; k < rows[r]->size(); k++) {
+      size_t i = (*rows[r])[k];
+      if (i < nf) {
+        out[r](k, 0) = founder[i];
+        out[r](k, 1) = "0";
+        out[r](k, 2) = "0";
+      } else {
+        out[r](k, 0) = kid[i - nf];
+        out[r](k, 1) = sir[i - nf];
+        out[r](k, 2) = dam[i - nf];
+      }
+    }
+  }
+  return List::create(_["ped"] = out[0], _["dup"] = out[1]);
+}
+
+// Generation order of a pedigree of unique individuals 'id' with parents
+// 'sir' and 'dam' ("0" if unknown). Parents that are not individuals of the
+// pedigree are added as founders ahead of the records; the rows below are
+// those of c(founder, id). Generations are peeled as in a topological sort:
+// the first holds the individuals without known parents, and every next one
+// those whose known parents are all placed. When no individual is left to
+// place the pedigree has a loop; the individuals with one placed parent then
+// lose the other one or, if there are none, all the rest lose both, as the
+// parents flagged in 'sirCleared' and 'damCleared'. Returned are the rows in
+// generation order ('order', 1-based), the generation of every row in that
+// order ('gen') and the parents coded as positions in that order ('sir' and
+// 'dam', 0 if unknown).
+// [[Rcpp::export]]
+List PedigreeSort(StringVector id, StringVector sir, StringVector dam) {
+  if (id.size() != sir.size() || id.size() != dam.size()) {
+    Rcpp::stop("'id', 'sir' and 'dam' should have the same length!");
+  }
+  size_t nr = id.size();
+
+  unordered_map<string, long> code;
+  code.reserve(2 * nr);
+  for (size_t i = 0; i < nr; i++) {
+    if (!code.emplace(as<string>(id[i]), i).second) {
+      Rcpp::stop("individual '" + as<string>(id[i]) + "' is duplicated!");
+    }
+  }
+  vector<string> founder;
+  vector<long> ps(nr), pd(nr);
+  StringVector *par[2] = {&sir, &dam};
+  vector<long> *pc[2] = {&ps, &pd};
+  for (int p = 0; p < 2; p++) {
+    for (size_t i = 0; i < nr; i++) {
+      string x = as<string>((*par[p])[i]);
+      if (x == "0") { (*pc[p])[i] = -1; continue; }
+      unordered_map<string, long>::iterator it = code.find(x);
+      if (it == code.end()) {
+        it = code.emplace(x, nr + founder.size()).first;
+        founder.push_back(x);
+      }
+      (*pc[p])[i] = it->second;
+    }
+  }
+
+  // rows of c(founder, id)
+  size_t nf = founder.size(), n = nf + nr;
+  vector<long> s(n, -1), d(n, -1);
+  auto row = [&](long c) -> long { return c < 0 ? -1 : (c < (long)nr ? c + (long)nf : c - (long)nr); };
+  for (size_t i = 0; i < nr; i++) {
+    s[nf + i] = row(ps[i]);
+    d[nf + i] = row(pd[i]);
+  }
+
+  // offspring lists
+  vector<size_t> start(n + 1, 0), child;
+  for (size_t i = 0; i < n; i++) {
+    if (s[i] >= 0) { start[s[i] + 1]++; }
+    if (d[i] >= 0) { start[d[i] + 1]++; }
+  }
+  for (size_t i = 0; i < n; i++) { start[i + 1] += start[i]; }
+  child.resize(start[n]);
+  vector<size_t> fill(start.begin(), start.end() - 1);
+  for (size_t i = 0; i < n; i++) {
+    if (s[i] >= 0) { child[fill[s[i]]++] = i; }
+    if (d[i] >= 0) { child[fill[d[i]]++] = i; }
+  }
+
+  vector<int> wait(n, 0);
+  for (size_t i = 0; i < n; i++) { wait[i] = (s[i] >= 0) + (d[i] >= 0); }
+  vector<long> pos(n, -1);
+  LogicalVector sirCleared(n), damCleared(n);
+  vector<size_t> order, layer, next;
+  vector<int> gen;
+  order.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    if (wait[i] == 0) { layer.push_back(i); }
+  }
+
+  int g = 0;
+  while (order.size() < n) {
+    if (layer.empty()) {
+      // a loop: individuals with one placed parent lose the other one
+      for (size_t i = 0; i < n; i++) {
+        if (pos[i] >= 0) { continue; }
+        bool sp = s[i] >= 0 && pos[s[i]] >= 0, dp = d[i] >= 0 && pos[d[i]] >= 0;
+        if (sp != dp) {
+          if (sp) { damCleared[i] = true; } else { sirCleared[i] = true; }
+          layer.push_back(i);
+        }
+      }
+      if (layer.empty()) {
+        for (size_t i = 0; i < n; i++) {
+          if (pos[i] >= 0) { continue; }
+          if (s[i] >= 0) { sirCleared[i] = true; }
+          if (d[i] >= 0) { damCleared[i] = true; }
+          layer.push_back(i);
+        }
+      }
+      // only the links to placed parents are kept
+      for (size_t k = 0; k < layer.size(); k++) {
+        size_t i = layer[k];
+        if (sirCleared[i]) { s[i] = -1; }
+        if (damCleared[i]) { d[i] = -1; }
+      }
+    }
+
+    g++;
+    sort(layer.begin(), layer.end());
+    for (size_t k = 0; k < layer.size(); k++) {
+      pos[layer[k]] = order.size();
+      order.push_back(layer[k]);
+      gen.push_back(g);
+    }
+    next.clear();
+    for (size_t k = 0; k < layer.size(); k++) {
+      size_t i = layer[k];
+      for (size_t c = start[i]; c < start[i + 1]; c++) {
+        size_t j = child[c];
+        if (pos[j] < 0 && --wait[j] == 0) { next.push_back(j); }
+      }
+    }
+    layer.swap(next);
+  }
+
+  IntegerVector ord(n), sc(n), dc(n);
+  for (size_t k = 0; k < n; k++) {
+    size_t i = order[k];
+    ord[k] = i + 1;
+    sc[k] = s[i] >= 0 ? pos[s[i]] + 1 : 0;
+    dc[k] = d[i] >= 0 ? pos[d[i]] + 1 : 0;
+  }
+  return List::create(
+    _["founder"] = founder,
+    _["order"] = ord,
+    _["gen"] = gen,
+    _["sir"] = sc,
+    _["dam"] = dc,
+    _["sirCleared"] = sirCleared,
+    _["damCleared"] = damCleared
+  );
+}
+
+// Families of offspring in one pass over a hash of their parents: the pair
+// (sire, dam) for mode "pm", the sire for "pat" and the dam for "mat".
+// Families are numbered from 'famOp' in the order of their first offspring,
+// and offspring within a family from 1; a missing parent of the key takes a
+// family number but leaves its offspring at 0, as getfam() always did.
+// 'size' and 'offset' give the offspring number of every family and its
+// start (0-based) in 'order', the offspring (1-based) grouped by family.
+// [[Rcpp::export]]
+List FamilyIndex(StringVector sir, StringVector dam, double famOp=1, std::string mode="pm") {
+  size_t n = sir.size();
+  if ((size_t)dam.size() != n) {
+    Rcpp::stop("'sir' and 'dam' should have the same length!");
+  }
+  bool useSir = mode == "pm" || mode == "pat", useDam = mode == "pm" || mode == "mat";
+  if (!useSir && !useDam) {
+    Rcpp::stop("Please input right mode!");
+  }
+
+  // parents interned from 1, 0 standing for NA
+  unordered_map<string, uint32_t> parIdx;
+  parIdx.reserve(n);
+  auto intern = [&](SEXP x) -> uint32_t {
+    if (x == NA_STRING) { return 0; }
+    return parIdx.emplace(string(CHAR(x)), parIdx.size() + 1).first->second;
+  };
+
+  unordered_map<uint64_t, int> famIdx;
+  famIdx.reserve(n);
+  vector<int> key(n);
+  vector<char> na(n, 0);
+  vector<int> size;
+  for (size_t i = 0; i < n; i++) {
+    uint64_t s = useSir ? intern(sir[i]) : 1, d = useDam ? intern(dam[i]) : 1;
+    na[i] = s == 0 || d == 0;
+    unordered_map<uint64_t, int>::iterator it = famIdx.emplace((s << 32) | d, (int)famIdx.size()).first;
+    key[i] = it->second;
+    if ((size_t)key[i] == size.size()) { size.push_back(0); }
+    if (!na[i]) { size[key[i]]++; }
+  }
+
+  size_t nfam = size.size();
+  vector<int> offset(nfam + 1, 0);
+  for (size_t f = 0; f < nfam; f++) { offset[f + 1] = offset[f] + size[f]; }
+  NumericVector fam(n);
+  IntegerVector infam(n), order(offset[nfam]);
+  vector<int> fill(offset.begin(), offset.end() - 1);
+  for (size_t i = 0; i < n; i++) {
+    if (na[i]) { continue; }
+    int f = key[i];
+    fam[i] = famOp + f;
+    infam[i] = fill[f] - offset[f] + 1;
+    order[fill[f]++] = i + 1;
+  }
+  offset.pop_back();
+  return List::create(
+    _["fam"] = fam,
+    _["infam"] = infam,
+    _["size"] = size,
+    _["offset"] = offset,
+    _["order"] = order
+  );
+}
@@ -0,0 +1,292 @@
+#include <Rcpp.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <queue>
+#include "simer_omp.h"
+
+// [[Rcpp::plugins(cpp11)]]
+using namespace std;
+using namespace Rcpp;
+
+// Numerator relationship matrix A of a pedigree given by the 1-based parent
+// positions 'sir' and 'dam' (0 if unknown), every parent preceding its
+// offspring. A is never formed: single elements are computed by the tabular
+// recursion
+//   A(i, i) = 1 + A(s_i, d_i) / 2,
+//   A(i, j) = (A(j, s_i) + A(j, d_i)) / 2   for j < i,
+// with a memo shared by all the queries, and products A x by the algorithm
+// of Colleau (2002), A = T D T', T being the unit lower triangular matrix of
+// gene flow and D the Mendelian sampling variances.
+class PedRelation {
+public:
+  PedRelation(const IntegerVector &sir, const IntegerVector &dam) : s(sir.begin(), sir.end()), d(dam.begin(), dam.end()) {
+    if (s.size() != d.size()) {
+      Rcpp::stop("'sir' and 'dam' should have the same length!");
+    }
+    for (size_t i = 0; i < s.size(); i++) {
+      if (s[i] < 0 || d[i] < 0 || (size_t)s[i] > i || (size_t)d[i] > i) {
+        Rcpp::stop("parents should precede their offspring in the pedigree!");
+      }
+    }
+  }
+
+  size_t size() const { return s.size(); }
+
+  // A(i, j), 1-based, 0 standing for an unknown individual
+  double get(int i, int j) {
+    if (i <= 0 || j <= 0) { return 0; }
+    double v;
+    if (lookup(i, j, v)) { return v; }
+
+    // the recursion with an explicit stack, as a pedigree can be deeper than
+    // the call stack allows
+    vector< pair<int, int> > stack(1, make_pair(max(i, j), min(i, j)));
+    while (!stack.empty()) {
+      int x = stack.back().first, y = stack.back().second;
+      if (lookup(x, y, v)) { stack.pop_back(); continue; }
+      int sx = s[x - 1], dx = d[x - 1];
+      pair<int, int> dep[2];
+      int ndep = 0;
+      if (x == y) {
+        if (sx > 0 && dx > 0) { dep[ndep++] = make_pair(max(sx, dx), min(sx, dx)); }
+      } else {
+        if (sx > 0) { dep[ndep++] = make_pair(max(y, sx), min(y, sx)); }
+        if (dx > 0) { dep[ndep++] = make_pair(max(y, dx), min(y, dx)); }
+      }
+      bool ready = true;
+      double a[2] = {0, 0};
+      for (int k = 0; k < ndep; k++) {
+        if (!lookup(dep[k].first, dep[k].second, a[k])) {
+          stack.push_back(dep[k]);
+          ready = false;
+        }
+      }
+      if (!ready) { continue; }
+      if (x == y) {
+        v = 1 + (ndep > 0 ? a[0] / 2 : 0);
+      } else {
+        v = (a[0] + a[1]) / 2;
+      }
+      memo[key(x, y)] = v;
+      stack.pop_back();
+    }
+    lookup(i, j, v);
+    return v;
+  }
+
+  // Y = A X, X being n x k column-major
+  void mult(const double *X, double *Y, size_t k) {
+    size_t n = s.size();
+
+    // Mendelian sampling variances, from the inbreeding of the parents
+    vector<double> D(n);
+    for (size_t i = 0; i < n; i++) {
+      double v = 1;
+      if (s[i] > 0) { v -= 0.25 * (1 + inbreeding(s[i])); }
+      if (d[i] > 0) { v -= 0.25 * (1 + inbreeding(d[i])); }
+      D[i] = v;
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t c = 0; c < k; c++) {
+      const double *x = X + c * n;
+      double *y = Y + c * n;
+      vector<double> v(x, x + n);
+      // v = T' x, from the youngest to the oldest
+      for (size_t i = n; i-- > 0; ) {
+        if (s[i] > 0) { v[s[i] - 1] += 0.5 * v[i]; }
+        if (d[i] > 0) { v[d[i] - 1] += 0.5 * v[i]; }
+      }
+      // y = T D v, from the oldest to the youngest
+      for (size_t i = 0; i < n; i++) {
+        double u = D[i] * v[i];
+        if (s[i] > 0) { u += 0.5 * y[s[i] - 1]; }
+        if (d[i] > 0) { u += 0.5 * y[d[i] - 1]; }
+        y[i] = u;
+      }
+    }
+  }
+
+  double inbreeding(int i) {
+    return get(i, i) - 1;
+  }
+
+private:
+  vector<int> s, d;
+  unordered_map<uint64_t, double> memo;
+
+  static uint64_t key(int x, int y) {
+    return ((uint64_t)x << 32) | (uint32_t)y;
+  }
+
+  bool lookup(int x, int y, double &v) {
+    if (x <= 0 || y <= 0) { v = 0; return true; }
+    if (x < y) { swap(x, y); }
+    if (x == y && (s[x - 1] == 0 || d[x - 1] == 0)) { v = 1; return true; }
+    unordered_map<uint64_t, double>::const_iterator it = memo.find(key(x, y));
+    if (it == memo.end()) { return false; }
+    v = it->second;
+    return true;
+  }
+};
+
+// elements A(i[k], j[k]) of the relationship matrix, 1-based
+// [[Rcpp::export]]
+NumericVector PedRelationPairs(IntegerVector sir, IntegerVector dam, IntegerVector i, IntegerVector j) {
+  if (i.size() != j.size()) {
+    Rcpp::stop("'i' and 'j' should have the same length!");
+  }
+  PedRelation A(sir, dam);
+  NumericVector res(i.size());
+  for (int k = 0; k < i.size(); k++) {
+    if (i[k] < 1 || j[k] < 1 || (size_t)i[k] > A.size() || (size_t)j[k] > A.size()) {
+      Rcpp::stop("'i' or 'j' is out of range!");
+    }
+    res[k] = A.get(i[k], j[k]);
+  }
+  return res;
+}
+
+// A X without forming A
+// [[Rcpp::export]]
+NumericMatrix PedRelationMult(IntegerVector sir, IntegerVector dam, NumericMatrix X, int threads=0) {
+  omp_setup(threads);
+  PedRelation A(sir, dam);
+  if ((size_t)X.nrow() != A.size()) {
+    Rcpp::stop("'X' should have as many rows as the pedigree!");
+  }
+  NumericMatrix Y(X.nrow(), X.ncol());
+  A.mult(X.begin(), Y.begin(), X.ncol());
+  return Y;
+}
+
+// Inbreeding coefficients by the algorithm of Meuwissen and Luo (1992): the
+// diagonal A(i, i) = sum_j L(i, j)^2 D(j) runs over the ancestors j of i only,
+// L(i, j) being pushed from the youngest ancestor to the oldest through a
+// max-heap, and full sibs share the coefficient of the previous one. The
+// first n0 coefficients of F are taken as known; D gets the Mendelian
+// sampling variances.
+static void ped_inbreeding(const IntegerVector &sir, const IntegerVector &dam, vector<double> &F, vector<double> &D, size_t n0) {
+  size_t n = F.size();
+  D.assign(n, 1);
+  vector<double> L(n, 0);
+  priority_queue<int> anc;
+  for (size_t i = 0; i < n; i++) {
+    int si = sir[i], di = dam[i];
+    if (si > 0) { D[i] -= 0.25 * (1 + F[si - 1]); }
+    if (di > 0) { D[i] -= 0.25 * (1 + F[di - 1]); }
+    if (i < n0) { continue; }
+    if (si == 0 || di == 0) { F[i] = 0; continue; }
+    if (i > n0 && si == sir[i - 1] && di == dam[i - 1]) { F[i] = F[i - 1]; continue; }
+
+    double a = D[i];
+    int p0[2] = {si - 1, di - 1};
+    for (int k = 0; k < 2; k++) {
+      if (L[p0[k]] == 0) { anc.push(p0[k]); }
+      L[p0[k]] += 0.5;
+    }
+    while (!anc.empty()) {
+      int j = anc.top();
+      anc.pop();
+      a += L[j] * L[j] * D[j];
+      int p[2] = {sir[j] - 1, dam[j] - 1};
+      for (int k = 0; k < 2; k++) {
+        if (p[k] < 0) { continue; }
+        if (L[p[k]] == 0) { anc.push(p[k]); }
+        L[p[k]] += 0.5 * L[j];
+      }
+      L[j] = 0;
+    }
+    F[i] = a - 1;
+  }
+}
+
+// inbreeding coefficients of the pedigree, the first length(F0) individuals
+// keeping their coefficients 'F0', so that a new generation appended to the
+// pedigree costs only its own ancestors
+// [[Rcpp::export]]
+NumericVector PedInbreeding(IntegerVector sir, IntegerVector dam, Nullable<NumericVector> F0=R_NilValue) {
+  // checks the order of the pedigree
+  PedRelation ped(sir, dam);
+  vector<double> F(ped.size(), 0), D;
+  size_t n0 = 0;
+  if (F0.isNotNull()) {
+    NumericVector f0 = as<NumericVector>(F0);
+    if ((size_t)f0.size() > F.size()) {
+      Rcpp::stop("'F0' should not be longer than the pedigree!");
+    }
+    n0 = f0.size();
+    copy(f0.begin(), f0.end(), F.begin());
+  }
+  ped_inbreeding(sir, dam, F, D, n0);
+  return wrap(F);
+}
+
+// Inverse of the relationship matrix by the rules of Henderson (1976) with
+// the Mendelian sampling variances D adjusted for the inbreeding of the
+// parents: every individual i adds 1 / D(i) times the outer product of
+// (1, -1/2, -1/2) over (i, sire, dam). Returned is the upper triangle in the
+// compressed column form of a dsCMatrix ('i', 'p', 'x', 0-based).
+// [[Rcpp::export]]
+List PedInverse(IntegerVector sir, IntegerVector dam, Nullable<NumericVector> F=R_NilValue) {
+  PedRelation ped(sir, dam);
+  size_t n = ped.size();
+  vector<double> f(n, 0), D;
+  if (F.isNotNull()) {
+    NumericVector f0 = as<NumericVector>(F);
+    if ((size_t)f0.size() != n) {
+      Rcpp::stop("'F' should have the same length as the pedigree!");
+    }
+    copy(f0.begin(), f0.end(), f.begin());
+  }
+  ped_inbreeding(sir, dam, f, D, F.isNotNull() ? n : 0);
+
+  // the entries of column j are rows <= j, the diagonal and the parents of
+  // j, and the offspring of j with their other parent
+  vector<size_t> start(n + 1, 0);
+  for (size_t i = 0; i < n; i++) {
+    int p[2] = {sir[i], dam[i]};
+    start[i + 1] += 1;
+    for (int k = 0; k < 2; k++) {
+      if (p[k] > 0) { start[i + 1] += 1; start[p[k]] += 1; }
+    }
+    if (p[0] > 0 && p[1] > 0) { start[max(p[0], p[1])] += 1; }
+  }
+  for (size_t j = 0; j < n; j++) { start[j + 1] += start[j]; }
+  vector< pair<int, double> > ent(start[n]);
+  vector<size_t> fill(start.begin(), start.end() - 1);
+  for (size_t i = 0; i < n; i++) {
+    double b = 1 / D[i];
+    int p[2] = {sir[i] - 1, dam[i] - 1};
+    ent[fill[i]++] = make_pair((int)i, b);
+    for (int k = 0; k < 2; k++) {
+      if (p[k] < 0) { continue; }
+      ent[fill[i]++] = make_pair(p[k], -b / 2);
+      ent[fill[p[k]]++] = make_pair(p[k], b / 4);
+    }
+    if (p[0] >= 0 && p[1] >= 0) {
+      // both halves of a selfing fall on the diagonal
+      ent[fill[max(p[0], p[1])]++] = make_pair(min(p[0], p[1]), p[0] == p[1] ? b / 2 : b / 4);
+    }
+  }
+
+  // sorted and merged columns
+  IntegerVector cp(n + 1);
+  vector<int> ri;
+  vector<double> rx;
+  ri.reserve(start[n]);
+  rx.reserve(start[n]);
+  for (size_t j = 0; j < n; j++) {
+    sort(ent.begin() + start[j], ent.begin() + start[j + 1]);
+    for (size_t k = start[j]; k < start[j + 1]; k++) {
+      if (!ri.empty() && (size_t)cp[j] < ri.size() && ri.back() == ent[k].first) {
+        rx.back() += ent[k].second;
+      } else {
+        ri.push_back(ent[k].first);
+        rx.push_back(ent[k].second);
+      }
+    }
+    cp[j + 1] = ri.size();
+  }
+  return List::create(_["i"] = ri, _["p"] = cp, _["x"] = rx, _["F"] = f);
+}
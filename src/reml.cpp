@@ -0,0 +1,259 @@
+#include <RcppArmadillo.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "packed.h"
+
+// [[Rcpp::plugins(cpp11)]]
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::depends(BH)]]
+using namespace std;
+using namespace Rcpp;
+
+// REML of y = X b + g + e, Var(y) = vg (K + delta I), by the spectral trick
+// of EMMA: with K = U diag(d) U', the rotated y* = U'y and X* = U'X have the
+// diagonal covariance vg (d + delta), so that the restricted likelihood of a
+// delta costs O(n p^2) instead of O(n^3). The decomposition only depends on
+// the kinship of the phenotyped individuals, it is done once and shared by
+// all traits and models on them.
+//
+// The decomposition is cached in a file of the layout
+//   bytes 0 - 7   : magic "SIMEREG2"
+//   bytes 8 - 15  : n, uint64
+//   bytes 16 - 23 : FNV-1a hash of the kinship, uint64
+//   then n eigenvalues and the n x n eigenvectors column by column, double.
+// The hash keys the cache on the content of the kinship, the same
+// individual IDs coming back with other genotypes in every simulation.
+#define SIMER_EIGEN_MAGIC "SIMEREG2"
+
+static uint64_t kin_hash(const arma::mat &K) {
+  return fnv1a(K.memptr(), K.n_elem * sizeof(double));
+}
+
+struct RemlData {
+  size_t n, p;
+  const double *d, *y, *X;   // X* being n x p, column-major
+  double ldXX;               // log|X'X|
+};
+
+// Cholesky of a p x p symmetric matrix in place (lower triangle), the log
+// determinant being returned; false if it is not positive definite.
+static bool reml_chol(vector<double> &A, size_t p, double &logdet) {
+  logdet = 0;
+  for (size_t j = 0; j < p; j++) {
+    double s = A[j * p + j];
+    for (size_t k = 0; k < j; k++) { s -= A[j * p + k] * A[j * p + k]; }
+    if (s <= 0) { return false; }
+    s = sqrt(s);
+    A[j * p + j] = s;
+    logdet += 2 * log(s);
+    for (size_t i = j + 1; i < p; i++) {
+      double t = A[i * p + j];
+      for (size_t k = 0; k < j; k++) { t -= A[i * p + k] * A[j * p + k]; }
+      A[i * p + j] = t / s;
+    }
+  }
+  return true;
+}
+
+// solve L L' x = b with the factor of reml_chol
+static void reml_chol_solve(const vector<double> &L, size_t p, vector<double> &b) {
+  for (size_t i = 0; i < p; i++) {
+    for (size_t k = 0; k < i; k++) { b[i] -= L[i * p + k] * b[k]; }
+    b[i] /= L[i * p + i];
+  }
+  for (size_t i = p; i-- > 0; ) {
+    for (size_t k = i + 1; k < p; k++) { b[i] -= L[k * p + i] * b[k]; }
+    b[i] /= L[i * p + i];
+  }
+}
+
+// X*' W X* and X*' W y* with W = diag(w)
+static void reml_normal(const RemlData &D, const double *w, vector<double> &A, vector<double> &b, double &yWy) {
+  size_t n = D.n, p = D.p;
+  A.assign(p * p, 0);
+  b.assign(p, 0);
+  yWy = 0;
+  for (size_t i = 0; i < n; i++) {
+    double wi = w ? w[i] : 1.0, yi = D.y[i];
+    yWy += wi * yi * yi;
+    for (size_t a = 0; a < p; a++) {
+      double xa = wi * D.X[a * n + i];
+      b[a] += xa * yi;
+      for (size_t c = 0; c <= a; c++) { A[a * p + c] += xa * D.X[c * n + i]; }
+    }
+  }
+}
+
+// Restricted log-likelihood at delta, vg being profiled out:
+//   -1/2 [(n - p) log(2 pi R / (n - p)) + (n - p) + sum log(d + delta)
+//         + log|X*' H^-1 X*| - log|X'X|],
+// R = y*' P y* being the weighted residual sum of squares.
+static double reml_loglik(const RemlData &D, double delta, vector<double> *beta=NULL, double *R=NULL) {
+  size_t n = D.n, p = D.p;
+  vector<double> w(n), A, b;
+  double ldH = 0, yWy, ldA;
+  for (size_t i = 0; i < n; i++) {
+    double h = D.d[i] + delta;
+    w[i] = 1 / h;
+    ldH += log(h);
+  }
+  reml_normal(D, w.data(), A, b, yWy);
+  if (!reml_chol(A, p, ldA)) { return -INFINITY; }
+
+  vector<double> bhat(b);
+  reml_chol_solve(A, p, bhat);
+  double r = yWy;
+  for (size_t a = 0; a < p; a++) { r -= b[a] * bhat[a]; }
+  if (r <= 0) { return -INFINITY; }
+  if (beta) { *beta = bhat; }
+  if (R) { *R = r; }
+
+  double np = n - p;
+  return -0.5 * (np * log(2 * M_PI * r / np) + np + ldH + ldA - D.ldXX);
+}
+
+// maximum on a grid of log(delta), every local maximum being refined by a
+// golden-section search between its neighbours
+static double reml_optim(const RemlData &D, int ngrids, double llim, double ulim, double tol) {
+  vector<double> grid(ngrids + 1), ll(ngrids + 1);
+  for (int k = 0; k <= ngrids; k++) {
+    grid[k] = llim + (ulim - llim) * k / ngrids;
+    ll[k] = reml_loglik(D, exp(grid[k]));
+  }
+
+  const double g = (sqrt(5.0) - 1) / 2;
+  double best = grid[0], bestLL = ll[0];
+  for (int k = 0; k <= ngrids; k++) {
+    bool peak = (k == 0 || ll[k] >= ll[k - 1]) && (k == ngrids || ll[k] >= ll[k + 1]);
+    if (!peak) { continue; }
+    double x = grid[k], fx = ll[k];
+    if (k > 0 && k < ngrids) {
+      double a = grid[k - 1], b = grid[k + 1];
+      double c = b - g * (b - a), e = a + g * (b - a);
+      double fc = reml_loglik(D, exp(c)), fe = reml_loglik(D, exp(e));
+      while (b - a > tol) {
+        if (fc > fe) {
+          b = e; e = c; fe = fc;
+          c = b - g * (b - a);
+          fc = reml_loglik(D, exp(c));
+        } else {
+          a = c; c = e; fc = fe;
+          e = a + g * (b - a);
+          fe = reml_loglik(D, exp(e));
+        }
+      }
+      double xm = (a + b) / 2, fm = reml_loglik(D, exp(xm));
+      if (fm > fx) { x = xm; fx = fm; }
+    }
+    if (fx > bestLL) { best = x; bestLL = fx; }
+  }
+  return exp(best);
+}
+
+// Eigen decomposition of a kinship, the eigenvalues being floored at 0;
+// it is saved in 'eig_file' if given.
+// [[Rcpp::export]]
+List KinEigen(arma::mat K, std::string eig_file="", bool verbose=true) {
+  if (K.n_rows != K.n_cols) {
+    Rcpp::stop("the kinship should be square!");
+  }
+  arma::vec d;
+  arma::mat U;
+  if (!arma::eig_sym(d, U, K, "dc")) {
+    Rcpp::stop("eigen decomposition of the kinship failed!");
+  }
+  d.elem(arma::find(d < 0)).zeros();
+
+  if (eig_file != "") {
+    FILE *f = fopen(eig_file.c_str(), "wb");
+    if (f == NULL) {
+      Rcpp::stop("cannot open file: %s", eig_file.c_str());
+    }
+    uint64_t nn = d.n_elem, key = kin_hash(K);
+    bool ok = fwrite(SIMER_EIGEN_MAGIC, 1, 8, f) == 8 && fwrite(&nn, 8, 1, f) == 1 && fwrite(&key, 8, 1, f) == 1 &&
+      fwrite(d.memptr(), 8, d.n_elem, f) == d.n_elem && fwrite(U.memptr(), 8, U.n_elem, f) == U.n_elem;
+    fclose(f);
+    if (!ok) {
+      Rcpp::stop("cannot write file: %s", eig_file.c_str());
+    }
+    if (verbose) { Rcout << "Eigen decomposition is saved in " << eig_file << endl; }
+  }
+  return List::create(_["values"] = NumericVector(d.begin(), d.end()), _["vectors"] = U);
+}
+
+// decomposition cached in 'eig_file', NULL if the file is not a cache of
+// the kinship 'K'
+// [[Rcpp::export]]
+SEXP KinEigenLoad(std::string eig_file, arma::mat K) {
+  FILE *f = fopen(eig_file.c_str(), "rb");
+  if (f == NULL) {
+    Rcpp::stop("cannot open file: %s", eig_file.c_str());
+  }
+  char magic[8];
+  uint64_t nn = 0, key = 0;
+  bool ok = fread(magic, 1, 8, f) == 8 && memcmp(magic, SIMER_EIGEN_MAGIC, 8) == 0 &&
+    fread(&nn, 8, 1, f) == 1 && fread(&key, 8, 1, f) == 1;
+  if (!ok || nn != K.n_rows || nn != K.n_cols || key != kin_hash(K)) {
+    fclose(f);
+    return R_NilValue;
+  }
+  arma::vec d;
+  arma::mat U;
+  if (ok) {
+    d.set_size(nn);
+    U.set_size(nn, nn);
+    ok = fread(d.memptr(), 8, d.n_elem, f) == d.n_elem && fread(U.memptr(), 8, U.n_elem, f) == U.n_elem;
+  }
+  fclose(f);
+  if (!ok) {
+    Rcpp::stop("not an eigen decomposition file: %s", eig_file.c_str());
+  }
+  return List::create(_["values"] = NumericVector(d.begin(), d.end()), _["vectors"] = U);
+}
+
+// REML of one trait on a decomposition of KinEigen, X being of full column
+// rank. alpha = (K + delta I)^-1 (y - X b), so that the BLUP of any
+// individual is its kinship to the phenotyped ones times alpha.
+// [[Rcpp::export]]
+List EmmaReml(arma::vec y, arma::mat X, arma::vec d, arma::mat U, int ngrids=100, double llim=-10, double ulim=10, double tol=1e-6) {
+  size_t n = y.n_elem, p = X.n_cols;
+  if (X.n_rows != n || d.n_elem != n || U.n_rows != n || U.n_cols != n) {
+    Rcpp::stop("'y', 'X' and the eigen decomposition should have the same individuals!");
+  }
+  if (p == 0 || p >= n) {
+    Rcpp::stop("'X' should have between 1 and n - 1 columns!");
+  }
+
+  arma::vec ety = U.t() * y;
+  arma::mat etX = U.t() * X;
+  RemlData D;
+  D.n = n; D.p = p;
+  D.d = d.memptr(); D.y = ety.memptr(); D.X = etX.memptr();
+  D.ldXX = 0;
+  vector<double> A, b;
+  double yy;
+  reml_normal(D, NULL, A, b, yy);
+  if (!reml_chol(A, p, D.ldXX)) {
+    Rcpp::stop("'X' is not of full column rank!");
+  }
+
+  double delta = reml_optim(D, ngrids, llim, ulim, tol);
+  vector<double> beta;
+  double R = 0;
+  double ll = reml_loglik(D, delta, &beta, &R);
+  if (!std::isfinite(ll)) {
+    Rcpp::stop("REML failed to converge!");
+  }
+  double vg = R / (n - p), ve = delta * vg;
+
+  // rotated residual, then back
+  arma::vec bhat(beta);
+  arma::vec r = ety - etX * bhat;
+  arma::vec alpha = U * (r / (d + delta));
+  arma::vec ebv = U * (r % d / (d + delta));
+
+  return List::create(_["vg"] = vg, _["ve"] = ve, _["delta"] = delta,
+                      _["beta"] = bhat, _["loglik"] = ll,
+                      _["alpha"] = alpha, _["ebv"] = ebv);
+}
@@ -0,0 +1,221 @@
+#include <RcppArmadillo.h>
+#include <bigmemory/BigMatrix.h>
+#include <bigmemory/MatrixAccessor.hpp>
+#include "simer_omp.h"
+#include "bitpack.h"
+#include "MinimalProgressBar.h"
+
+// [[Rcpp::plugins(cpp11)]]
+// [[Rcpp::depends(RcppArmadillo)]]
+// [[Rcpp::depends(bigmemory, BH)]]
+using namespace std;
+using namespace Rcpp;
+
+struct ROHSeg {
+  int ind, start, end, nHet;
+};
+
+// Scan the runs of homozygosity of one individual. 'het' and 'brk' are
+// bit masks over markers: heterozygous genotypes of the individual, and
+// markers starting a chromosome or following a gap larger than 'maxGap'.
+// Only the set bits of het | brk are visited, so the cost is proportional
+// to the number of heterozygotes rather than the number of markers. A run
+// absorbs at most 'maxHet' heterozygotes, and always starts and ends at a
+// homozygous marker.
+static void ROHScan(const vector<uint64_t> &het, const vector<uint64_t> &brk, const vector<double> &bp, size_t m,
+                    int minSNP, double minBP, int maxHet, double maxDensity, int ind, vector<ROHSeg> &segs) {
+  long runStart = 0, lastHom = -1;
+  int nHet = 0, nHetAtHom = 0;
+  size_t nw = het.size();
+
+  // a run [runStart, lastHom] is reported if it passes all thresholds
+  auto close = [&]() {
+    if (lastHom < runStart) { return; }
+    int nSNP = lastHom - runStart + 1;
+    double len = bp[lastHom] - bp[runStart];
+    if (nSNP < minSNP || len < minBP) { return; }
+    if (maxDensity > 0 && len / nSNP > maxDensity) { return; }
+    ROHSeg s = { ind, (int)runStart, (int)lastHom, nHetAtHom };
+    segs.push_back(s);
+  };
+
+  long prev = -1;
+  auto visit = [&](long e) {
+    // markers between two events are homozygous (or missing)
+    if (e - 1 > prev) {
+      lastHom = e - 1;
+      nHetAtHom = nHet;
+    }
+    prev = e;
+    if (e == (long)m) {
+      close();
+      return;
+    }
+    bool isBrk = (brk[e / 64] >> (e % 64)) & 1ULL;
+    bool isHet = (het[e / 64] >> (e % 64)) & 1ULL;
+    if (isBrk) {
+      close();
+      runStart = e; lastHom = e - 1; nHet = 0; nHetAtHom = 0;
+    }
+    if (isHet) {
+      if (!isBrk && nHet < maxHet && lastHom >= runStart) {
+        nHet++;
+      } else {
+        close();
+        runStart = e + 1; lastHom = e; nHet = 0; nHetAtHom = 0;
+      }
+    } else {
+      lastHom = e;
+      nHetAtHom = nHet;
+    }
+  };
+
+  for (size_t w = 0; w < nw; w++) {
+    uint64_t x = het[w] | brk[w];
+    while (x) {
+      visit(w * 64 + ctz64(x));
+      x &= x - 1;
+    }
+  }
+  visit(m);
+}
+
+template <typename T>
+List ROHCall(XPtr<BigMatrix> pMat, IntegerVector chrom, NumericVector pos, int incols=2, int minSNP=50, double minBP=1e6,
+             int maxHet=1, double maxGap=1e6, double maxDensity=5e4, bool keepSegments=false, int threads=0, bool verbose=true) {
+  omp_setup(threads);
+
+  MatrixAccessor<T> bigm = MatrixAccessor<T>(*pMat);
+  size_t m = pMat->nrow(), ncol = pMat->ncol();
+  if (chrom.size() != (int)m || pos.size() != (int)m) {
+    Rcpp::stop("'chrom' and 'pos' should have the same length as marker number!");
+  }
+  if (incols != 1 && incols != 2) {
+    Rcpp::stop("'incols' should only be 1 or 2!");
+  }
+  if (incols == 2 && ncol % 2 != 0) {
+    Rcpp::stop("the column number of genotype should be even when 'incols' is 2!");
+  }
+  if (maxHet < 0) { Rcpp::stop("'maxHet' should not be negative!"); }
+  size_t n = ncol / incols;
+  size_t nw = (m + 63) / 64;
+  vector<double> bp(pos.begin(), pos.end());
+
+  // chromosome starts and large gaps are shared by all individuals
+  vector<uint64_t> brk(nw, 0);
+  double genomeLen = 0, chrStart = 0;
+  for (size_t i = 0; i < m; i++) {
+    bool newChr = (i == 0) || (chrom[i] != chrom[i - 1]);
+    if (newChr || (maxGap > 0 && bp[i] - bp[i - 1] > maxGap)) {
+      brk[i / 64] |= 1ULL << (i % 64);
+    }
+    if (newChr) {
+      if (i > 0) { genomeLen += bp[i - 1] - chrStart; }
+      chrStart = bp[i];
+    }
+  }
+  if (m > 0) { genomeLen += bp[m - 1] - chrStart; }
+
+  NumericVector lenROH(n, 0.0), froh(n, 0.0);
+  IntegerVector nROH(n, 0);
+  vector<ROHSeg> allSegs;
+
+  MinimalProgressBar pb;
+  Progress p(n, verbose, pb);
+
+  if (verbose) { Rcout << " Scanning runs of homozygosity of " << n << " individuals..." << endl; }
+
+  #pragma omp parallel
+  {
+    vector<uint64_t> het(nw);
+    vector<ROHSeg> segs, lsegs;
+
+    #pragma omp for schedule(dynamic)
+    for (size_t u = 0; u < n; u++) {
+      std::fill(het.begin(), het.end(), 0);
+      if (incols == 2) {
+        T *c1 = bigm[2 * u], *c2 = bigm[2 * u + 1];
+        for (size_t i = 0; i < m; i++) {
+          T x1 = c1[i], x2 = c2[i];
+          if ((x1 == 0 && x2 == 1) || (x1 == 1 && x2 == 0)) { het[i / 64] |= 1ULL << (i % 64); }
+        }
+      } else {
+        T *c1 = bigm[u];
+        for (size_t i = 0; i < m; i++) {
+          if (c1[i] == 1) { het[i / 64] |= 1ULL << (i % 64); }
+        }
+      }
+
+      segs.clear();
+      ROHScan(het, brk, bp, m, minSNP, minBP, maxHet, maxDensity, u + 1, segs);
+      double len = 0;
+      for (size_t k = 0; k < segs.size(); k++) { len += bp[segs[k].end] - bp[segs[k].start]; }
+      nROH[u] = segs.size();
+      lenROH[u] = len;
+      froh[u] = genomeLen > 0 ? len / genomeLen : NA_REAL;
+      if (keepSegments) { lsegs.insert(lsegs.end(), segs.begin(), segs.end()); }
+      if ( ! Progress::check_abort() ) { p.increment(); }
+    }
+
+    if (keepSegments) {
+      #pragma omp critical
+      { allSegs.insert(allSegs.end(), lsegs.begin(), lsegs.end()); }
+    }
+  }
+
+  DataFrame summ = DataFrame::create(
+    Named("nROH")  = nROH,
+    _["lenROH"]    = lenROH,
+    _["FROH"]      = froh
+  );
+  if (!keepSegments) {
+    return List::create(Named("ind") = summ, _["seg"] = R_NilValue, _["genomeLen"] = genomeLen);
+  }
+
+  // individuals finish out of order
+  std::sort(allSegs.begin(), allSegs.end(), [](const ROHSeg &x, const ROHSeg &y) {
+    return x.ind != y.ind ? x.ind < y.ind : x.start < y.start;
+  });
+  size_t ns = allSegs.size();
+  IntegerVector sInd(ns), sChr(ns), sStart(ns), sEnd(ns), sNSNP(ns), sNHet(ns);
+  NumericVector sStartBP(ns), sEndBP(ns), sLen(ns);
+  for (size_t k = 0; k < ns; k++) {
+    const ROHSeg &s = allSegs[k];
+    sInd[k] = s.ind; sChr[k] = chrom[s.start];
+    sStart[k] = s.start + 1; sEnd[k] = s.end + 1;
+    sStartBP[k] = bp[s.start]; sEndBP[k] = bp[s.end];
+    sLen[k] = bp[s.end] - bp[s.start];
+    sNSNP[k] = s.end - s.start + 1; sNHet[k] = s.nHet;
+  }
+  DataFrame seg = DataFrame::create(
+    Named("ind")   = sInd,
+    _["chrom"]     = sChr,
+    _["start"]     = sStart,
+    _["end"]       = sEnd,
+    _["startBP"]   = sStartBP,
+    _["endBP"]     = sEndBP,
+    _["length"]    = sLen,
+    _["nSNP"]      = sNSNP,
+    _["nHet"]      = sNHet
+  );
+  return List::create(Named("ind") = summ, _["seg"] = seg, _["genomeLen"] = genomeLen);
+}
+
+// [[Rcpp::export]]
+List ROHCall(SEXP pBigMat, IntegerVector chrom, NumericVector pos, int incols=2, int minSNP=50, double minBP=1e6,
+             int maxHet=1, double maxGap=1e6, double maxDensity=5e4, bool keepSegments=false, int threads=0, bool verbose=true) {
+  XPtr<BigMatrix> xpMat(pBigMat);
+
+  switch(xpMat->matrix_type()) {
+  case 1:
+    return ROHCall<char>(xpMat, chrom, pos, incols, minSNP, minBP, maxHet, maxGap, maxDensity, keepSegments, threads, verbose);
+  case 2:
+    return ROHCall<short>(xpMat, chrom, pos, incols, minSNP, minBP, maxHet, maxGap, maxDensity, keepSegments, threads, verbose);
+  case 4:
+    return ROHCall<int>(xpMat, chrom, pos, incols, minSNP, minBP, maxHet, maxGap, maxDensity, keepSegments, threads, verbose);
+  case 8:
+    return ROHCall<double>(xpMat, chrom, pos, incols, minSNP, minBP, maxHet, maxGap, maxDensity, keepSegments, threads, verbose);
+  default:
+    throw Rcpp::exception("unknown type detected for big.matrix object!");
+  }
+}
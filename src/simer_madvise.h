@@ -0,0 +1,59 @@
+#ifndef SIMER_MADVISE_H_
+#define SIMER_MADVISE_H_
+
+#include <Rcpp.h>
+#include <stdint.h>
+#include <bigmemory/BigMatrix.h>
+#include <bigmemory/MatrixAccessor.hpp>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// [[Rcpp::plugins(cpp11)]]
+
+// access pattern hints for the pages of a file-backed big.matrix
+enum BigMatAdvice { BM_NORMAL, BM_SEQUENTIAL, BM_WILLNEED, BM_DONTNEED };
+
+// only file-backed columns are advised: dropping pages of an anonymous
+// (local) matrix would discard its data, and separated columns are not
+// laid out in one contiguous mapping
+static inline bool bigmat_advisable(BigMatrix *pMat) {
+  return (dynamic_cast<FileBackedBigMatrix*>(pMat) != NULL) && !pMat->separated_columns();
+}
+
+template <typename T>
+static inline void bigmat_advise(BigMatrix *pMat, size_t colStart, size_t colEnd, BigMatAdvice advice) {
+#if !defined(_WIN32)
+  if (colStart >= colEnd || !bigmat_advisable(pMat)) { return; }
+
+  MatrixAccessor<T> bigm = MatrixAccessor<T>(*pMat);
+  size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t op = reinterpret_cast<uintptr_t>(bigm[colStart]);
+  uintptr_t ed = reinterpret_cast<uintptr_t>(bigm[colEnd - 1] + pMat->nrow());
+  op = op - op % page;
+
+  int adv = MADV_NORMAL;
+  switch (advice) {
+  case BM_SEQUENTIAL: adv = MADV_SEQUENTIAL; break;
+  case BM_WILLNEED:   adv = MADV_WILLNEED;   break;
+  case BM_DONTNEED:   adv = MADV_DONTNEED;   break;
+  default:            adv = MADV_NORMAL;     break;
+  }
+  // advice is only a hint, failure is harmless
+  madvise(reinterpret_cast<void*>(op), ed - op, adv);
+#endif
+}
+
+// number of columns per block so that one block occupies about memLimit MB
+static inline size_t bigmat_block_cols(BigMatrix *pMat, double memLimit, size_t typeSize) {
+  double colBytes = static_cast<double>(pMat->nrow()) * typeSize;
+  if (colBytes <= 0) { return 1; }
+  double nc = memLimit * 1024 * 1024 / colBytes;
+  if (nc < 1) { return 1; }
+  if (nc > pMat->ncol()) { return pMat->ncol(); }
+  return static_cast<size_t>(nc);
+}
+
+#endif